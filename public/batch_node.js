@@ -0,0 +1,65 @@
+// Runs the batch API headlessly in node and checks that the threaded version agrees with the single threaded one
+//
+// Usage:
+//   make wasm-lib && node public/batch_node.js
+//   make wasm-threads && node public/batch_node.js gen/gjk_threads.js
+const path = require("path");
+
+const createGjkModule = require(path.join(__dirname, process.argv[2] || "gen/gjk.js"));
+
+const NUM_POLYGONS = 2000;
+
+createGjkModule().then((gjk) => {
+	// Random axis aligned boxes in a 1000x1000 area
+	const coords = new Int32Array(NUM_POLYGONS * 8);
+	const offsets = new Int32Array(NUM_POLYGONS + 1);
+	for (let i = 0; i < NUM_POLYGONS; i++) {
+		const x = Math.floor(Math.random() * 1000), y = Math.floor(Math.random() * 1000);
+		const w = 5 + Math.floor(Math.random() * 30), h = 5 + Math.floor(Math.random() * 30);
+		coords.set([x, y, x, y + h, x + w, y + h, x + w, y], 8 * i);
+		offsets[i] = 4 * i;
+	}
+	offsets[NUM_POLYGONS] = 4 * NUM_POLYGONS;
+
+	// Check every polygon against its next 100 neighbours
+	const pairs = [];
+	for (let i = 0; i < NUM_POLYGONS; i++) {
+		for (let j = i + 1; j < Math.min(i + 100, NUM_POLYGONS); j++) {
+			pairs.push(i, j);
+		}
+	}
+	const numPairs = pairs.length / 2;
+
+	const coordsPtr = gjk._malloc(coords.byteLength);
+	const offsetsPtr = gjk._malloc(offsets.byteLength);
+	const pairsPtr = gjk._malloc(pairs.length * 4);
+	const hitsPtr = gjk._malloc(numPairs);
+	const penetrationsPtr = gjk._malloc(numPairs * 8);
+	gjk.HEAP32.set(coords, coordsPtr >> 2);
+	gjk.HEAP32.set(offsets, offsetsPtr >> 2);
+	gjk.HEAP32.set(pairs, pairsPtr >> 2);
+
+	let start = performance.now();
+	const numHits = gjk.batchCollision(coordsPtr, offsetsPtr, NUM_POLYGONS, pairsPtr, numPairs, hitsPtr, penetrationsPtr);
+	console.log(`batchCollision: ${numPairs} pairs, ${numHits} hits in ${(performance.now() - start).toFixed(2)} ms`);
+
+	if (gjk.batchCollisionParallel) {
+		const hits = gjk.HEAPU8.slice(hitsPtr, hitsPtr + numPairs);
+		const penetrations = gjk.HEAP32.slice(penetrationsPtr >> 2, (penetrationsPtr >> 2) + 2 * numPairs);
+
+		start = performance.now();
+		const numHitsParallel = gjk.batchCollisionParallel(coordsPtr, offsetsPtr, NUM_POLYGONS, pairsPtr, numPairs, hitsPtr, penetrationsPtr, gjk.BATCH_MAX_THREADS);
+		console.log(`batchCollisionParallel (${gjk.BATCH_MAX_THREADS} threads): ${numHitsParallel} hits in ${(performance.now() - start).toFixed(2)} ms`);
+
+		const same = numHits === numHitsParallel
+			&& hits.every((hit, i) => hit === gjk.HEAPU8[hitsPtr + i])
+			&& penetrations.every((p, i) => p === gjk.HEAP32[(penetrationsPtr >> 2) + i]);
+		if (!same) {
+			console.error("ERROR: batchCollisionParallel doesn't match batchCollision");
+			process.exit(1);
+		}
+	}
+
+	// The worker pool keeps node alive otherwise
+	process.exit(0);
+});
@@ -1,2 +1,19 @@
 #!/bin/bash
+# Usage: ./serve.sh [--threads]
+# --threads sends the COOP/COEP headers that browsers require before they allow SharedArrayBuffer (needed by `make wasm-threads`)
+if [ "$1" == "--threads" ]; then
+python3 - "$(dirname "$0")" <<'PYTHON'
+import functools, http.server, sys
+
+class CrossOriginIsolatedHandler(http.server.SimpleHTTPRequestHandler):
+    def end_headers(self):
+        self.send_header("Cross-Origin-Opener-Policy", "same-origin")
+        self.send_header("Cross-Origin-Embedder-Policy", "require-corp")
+        super().end_headers()
+
+handler = functools.partial(CrossOriginIsolatedHandler, directory=sys.argv[1])
+http.server.ThreadingHTTPServer(("127.0.0.1", 8000), handler).serve_forever()
+PYTHON
+else
 python3 -m http.server 8000 --bind 127.0.0.1 --directory $(dirname "$0")
+fi
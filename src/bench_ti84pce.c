@@ -0,0 +1,122 @@
+#if defined(TI84PCE) && defined(BENCHMARK)
+#include <stdint.h>
+#include <sys/timers.h>
+#include <debug.h>
+#include <graphx.h>
+#include <keypadc.h>
+
+#include "gjk_epa/gjk.h"
+#include "gjk_epa/epa.h"
+
+#include "bench_ti84pce.h"
+
+#define NUM_RUNS 100
+
+// Written to after every call so the compiler can't drop the work being timed
+volatile scalar_t sink;
+
+struct vector_t square[] = {
+	{60, 30}, {60, 60}, {120, 60}, {120, 30},
+};
+struct vector_t pentagon_hit[] = {
+	{100, 40}, {70, 60}, {85, 100}, {115, 100}, {130, 60},
+};
+struct vector_t pentagon_miss[] = {
+	{200, 140}, {170, 160}, {185, 200}, {215, 200}, {230, 160},
+};
+
+// Counts CPU cycles (48 MHz) on timer 1
+static void timer_start(void) {
+	timer_Disable(1);
+	timer_Set(1, 0);
+	timer_Enable(1, TIMER_CPU, TIMER_NOINT, TIMER_UP);
+}
+
+static uint32_t timer_stop(void) {
+	timer_Disable(1);
+	return timer_Get(1);
+}
+
+static void report(const char* name, uint32_t cycles, int y) {
+	uint32_t per_call = cycles / NUM_RUNS;
+
+	// Shows up in CEmu's debug console, so the benchmark can be read without looking at the screen
+	dbg_printf("%s: %lu cycles/call\n", name, (unsigned long)per_call);
+
+	gfx_PrintStringXY(name, 2, y);
+	gfx_SetTextXY(120, y);
+	gfx_PrintUInt(per_call, 8);
+}
+
+void run_benchmark(void) {
+	struct vector_t a = {123, -45}, b = {-67, 89}, c = {31, 17};
+	uint32_t cycles;
+	int y = 2;
+
+	gfx_FillScreen(0xFF);
+	gfx_SetTextFGColor(0x00);
+
+	timer_start();
+	for (int i = 0; i < NUM_RUNS; i++) {
+		sink = dot(a, b);
+	}
+	report("dot", timer_stop(), y += 10);
+
+	timer_start();
+	for (int i = 0; i < NUM_RUNS; i++) {
+		sink = triple_product2(a, b, c).x;
+	}
+	report("triple_product2", timer_stop(), y += 10);
+
+	timer_start();
+	for (int i = 0; i < NUM_RUNS; i++) {
+		sink = int_sqrt(1234567 + i);
+	}
+	report("int_sqrt", timer_stop(), y += 10);
+
+	struct polygon_t poly1 = {square, sizeof(square)/sizeof(square[0])};
+	struct polygon_t hit = {pentagon_hit, sizeof(pentagon_hit)/sizeof(pentagon_hit[0])};
+	struct polygon_t miss = {pentagon_miss, sizeof(pentagon_miss)/sizeof(pentagon_miss[0])};
+
+	timer_start();
+	for (int i = 0; i < NUM_RUNS; i++) {
+		sink = gjk_collision(poly1, hit, NULL);
+	}
+	report("gjk_collision hit", timer_stop(), y += 10);
+
+	timer_start();
+	for (int i = 0; i < NUM_RUNS; i++) {
+		sink = gjk_collision(poly1, miss, NULL);
+	}
+	report("gjk_collision miss", timer_stop(), y += 10);
+
+	// epa rescales the polygons it's given, so it gets fresh copies every run.
+	// The copies are timed too, but they're cheap compared to EPA
+	struct vector_t points1[sizeof(square)/sizeof(square[0])];
+	struct vector_t points2[sizeof(pentagon_hit)/sizeof(pentagon_hit[0])];
+	struct polygon_t copy1 = {points1, poly1.num_points};
+	struct polygon_t copy2 = {points2, hit.num_points};
+
+	timer_start();
+	for (int i = 0; i < NUM_RUNS; i++) {
+		for (int j = 0; j < copy1.num_points; j++) {
+			points1[j] = square[j];
+		}
+		for (int j = 0; j < copy2.num_points; j++) {
+			points2[j] = pentagon_hit[j];
+		}
+		sink = epa(copy1, copy2).x;
+	}
+	report("epa", timer_stop(), y += 10);
+
+	gfx_PrintStringXY("Press any key to exit", 2, y + 20);
+	gfx_SwapDraw();
+
+	dbg_printf("done\n");
+
+	while (!kb_AnyKey()) {
+		kb_Scan();
+	}
+}
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef BENCH_TI84PCE_H
+#define BENCH_TI84PCE_H
+
+#if defined(TI84PCE) && defined(BENCHMARK)
+/**
+ * Times the vector math, GJK and EPA in CPU cycles and prints the results to the screen and to the CEmu debug console
+ */
+void run_benchmark(void);
+#endif
+#endif
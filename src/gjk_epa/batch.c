@@ -0,0 +1,257 @@
+#include <time.h>
+#if defined(__wasm_simd128__) && !defined(GJK_NARROW_SCALAR)
+#include <wasm_simd128.h>
+#endif
+#ifdef GJK_PTHREADS
+#include <pthread.h>
+#endif
+#include "batch.h"
+#include "gjk.h"
+#include "epa.h"
+
+/*
+ * A polygon of the batch, read in place from the packed int32 coordinates
+ */
+struct packed_polygon_t {
+	const int32_t* coords;
+	int num_points;
+};
+
+static struct packed_polygon_t packed_polygon(struct batch_polygons_t polys, int idx) {
+	return (struct packed_polygon_t) {
+		.coords = polys.coords + 2*polys.offsets[idx],
+		.num_points = polys.offsets[idx+1] - polys.offsets[idx],
+	};
+}
+
+// get_farthest_point_in_direction on the packed coordinates, as a farthest_point_fn
+static struct vector_t packed_farthest_point(const void* shape, struct vector_t d) {
+	const struct packed_polygon_t* poly = shape;
+	const int32_t* coords = poly->coords;
+	scalar_t max_dp = (scalar_t)coords[0] * d.x + (scalar_t)coords[1] * d.y;
+	int max_idx = 0;
+	int i = 1;
+
+#if defined(__wasm_simd128__) && !defined(GJK_NARROW_SCALAR)
+	// Two points are one load, widened to 64 bits in the register. Ties still go to the first point like the scalar loop
+	v128_t dx = wasm_i64x2_splat(d.x);
+	v128_t dy = wasm_i64x2_splat(d.y);
+	for (; i + 1 < poly->num_points; i += 2) {
+		v128_t p = wasm_v128_load(&coords[2*i]);          // (x_i, y_i, x_i+1, y_i+1)
+		v128_t xy = wasm_i32x4_shuffle(p, p, 0, 2, 1, 3); // (x_i, x_i+1, y_i, y_i+1)
+		v128_t xs = wasm_i64x2_extend_low_i32x4(xy);
+		v128_t ys = wasm_i64x2_extend_high_i32x4(xy);
+		v128_t dps = wasm_i64x2_add(wasm_i64x2_mul(xs, dx), wasm_i64x2_mul(ys, dy));
+
+		int64_t dp0 = wasm_i64x2_extract_lane(dps, 0);
+		int64_t dp1 = wasm_i64x2_extract_lane(dps, 1);
+		if (dp0 > max_dp) {
+			max_dp = dp0;
+			max_idx = i;
+		}
+		if (dp1 > max_dp) {
+			max_dp = dp1;
+			max_idx = i + 1;
+		}
+	}
+#endif
+
+	for (; i < poly->num_points; i++) {
+		scalar_t dp = (scalar_t)coords[2*i] * d.x + (scalar_t)coords[2*i+1] * d.y;
+		if (dp > max_dp) {
+			max_dp = dp;
+			max_idx = i;
+		}
+	}
+
+	return (struct vector_t){coords[2*max_idx], coords[2*max_idx+1]};
+}
+
+// Same as get_centroid
+static struct vector_t packed_centroid(struct packed_polygon_t poly) {
+	scalar_t sum_x = 0, sum_y = 0;
+	for (int i = 0; i < poly.num_points; i++) {
+		sum_x += poly.coords[2*i];
+		sum_y += poly.coords[2*i+1];
+	}
+	return (struct vector_t){sum_x / poly.num_points, sum_y / poly.num_points};
+}
+
+// Same as collide_options and collision_penetration, without copying the polygons out of the batch
+static bool collide_pair(struct batch_polygons_t polys, int a, int b, int32_t* penetration, const struct query_options_t* options,
+		int* iterations, enum query_status_t* status) {
+	struct packed_polygon_t poly1 = packed_polygon(polys, a);
+	struct packed_polygon_t poly2 = packed_polygon(polys, b);
+	struct vector_t d = sub(packed_centroid(poly2), packed_centroid(poly1));
+
+	struct simplex_t simplex;
+	int gjk_iterations, epa_iterations = 0;
+	bool colliding = gjk_collision_generic(packed_farthest_point, &poly1, packed_farthest_point, &poly2, d, options,
+			&simplex, &gjk_iterations, status);
+
+	if (penetration != NULL) {
+		struct vector_t p = {0, 0};
+		if (colliding) {
+			p = epa_from_simplex_generic(packed_farthest_point, &poly1, packed_farthest_point, &poly2, &simplex, NULL, options,
+					&epa_iterations, status);
+		}
+		penetration[0] = p.x;
+		penetration[1] = p.y;
+	}
+
+	*iterations = gjk_iterations + epa_iterations;
+	return colliding;
+}
+
+static int64_t now_ns(void) {
+#ifdef TI84PCE
+	return (int64_t)clock() * (1000000000 / CLOCKS_PER_SEC);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/**
+ * Checks pairs until the deadline (0 for none) passes or budget_iterations (0 for no limit) are used up
+ */
+static int batch_range(struct batch_polygons_t polys, const int32_t* pairs, int num_pairs, uint8_t* hits, int32_t* penetrations,
+		const struct query_options_t* options, uint8_t* statuses, int64_t deadline_ns, long budget_iterations) {
+	int num_hits = 0;
+	long total_iterations = 0;
+
+	for (int i = 0; i < num_pairs; i++) {
+		int32_t* penetration = penetrations == NULL ? NULL : &penetrations[2*i];
+
+		bool over_budget = (deadline_ns != 0 && now_ns() >= deadline_ns)
+				|| (budget_iterations != 0 && total_iterations >= budget_iterations);
+		if (over_budget) {
+			hits[i] = 0;
+			if (penetration != NULL) {
+				penetration[0] = penetration[1] = 0;
+			}
+			if (statuses != NULL) {
+				statuses[i] = QUERY_SKIPPED;
+			}
+			continue;
+		}
+
+		int iterations;
+		enum query_status_t status;
+		bool colliding = collide_pair(polys, pairs[2*i], pairs[2*i+1], penetration, options, &iterations, &status);
+
+		hits[i] = colliding;
+		num_hits += colliding;
+		total_iterations += iterations;
+		if (statuses != NULL) {
+			statuses[i] = status;
+		}
+	}
+
+	return num_hits;
+}
+
+static int64_t deadline_of(const struct query_options_t* options) {
+	return options != NULL && options->budget_ns > 0 ? now_ns() + options->budget_ns : 0;
+}
+
+int batch_collision(struct batch_polygons_t polys, const int32_t* pairs, int num_pairs, uint8_t* hits, int32_t* penetrations) {
+	return batch_range(polys, pairs, num_pairs, hits, penetrations, NULL, NULL, 0, 0);
+}
+
+int batch_collision_options(struct batch_polygons_t polys, const int32_t* pairs, int num_pairs, uint8_t* hits, int32_t* penetrations,
+		const struct query_options_t* options, uint8_t* statuses) {
+	long budget_iterations = options != NULL ? options->budget_iterations : 0;
+	return batch_range(polys, pairs, num_pairs, hits, penetrations, options, statuses, deadline_of(options), budget_iterations);
+}
+
+#ifdef GJK_PTHREADS
+
+struct batch_chunk_t {
+	struct batch_polygons_t polys;
+	const int32_t* pairs;
+	int num_pairs;
+	uint8_t* hits;
+	int32_t* penetrations;
+	const struct query_options_t* options;
+	uint8_t* statuses;
+	int64_t deadline_ns;
+	long budget_iterations;
+	int num_hits;
+};
+
+static void* batch_collision_chunk(void* arg) {
+	struct batch_chunk_t* chunk = arg;
+	chunk->num_hits = batch_range(chunk->polys, chunk->pairs, chunk->num_pairs, chunk->hits, chunk->penetrations,
+			chunk->options, chunk->statuses, chunk->deadline_ns, chunk->budget_iterations);
+	return NULL;
+}
+
+int batch_collision_parallel(struct batch_polygons_t polys, const int32_t* pairs, int num_pairs, uint8_t* hits, int32_t* penetrations, int num_threads) {
+	return batch_collision_parallel_options(polys, pairs, num_pairs, hits, penetrations, NULL, NULL, num_threads);
+}
+
+int batch_collision_parallel_options(struct batch_polygons_t polys, const int32_t* pairs, int num_pairs, uint8_t* hits, int32_t* penetrations,
+		const struct query_options_t* options, uint8_t* statuses, int num_threads) {
+	if (num_threads > BATCH_MAX_THREADS) {
+		num_threads = BATCH_MAX_THREADS;
+	}
+	if (num_threads > num_pairs) {
+		num_threads = num_pairs;
+	}
+	if (num_threads <= 1) {
+		return batch_collision_options(polys, pairs, num_pairs, hits, penetrations, options, statuses);
+	}
+
+	// The chunks run at the same time, so they share the deadline but split the iterations
+	int64_t deadline_ns = deadline_of(options);
+	long budget_iterations = 0;
+	if (options != NULL && options->budget_iterations > 0) {
+		budget_iterations = options->budget_iterations / num_threads > 0 ? options->budget_iterations / num_threads : 1;
+	}
+
+	struct batch_chunk_t chunks[BATCH_MAX_THREADS];
+	pthread_t threads[BATCH_MAX_THREADS];
+	bool started[BATCH_MAX_THREADS] = {false};
+
+	// Every pair writes to its own slot in hits and penetrations, so the chunks don't need any locking
+	int chunk_size = (num_pairs + num_threads - 1) / num_threads;
+	for (int t = 0; t < num_threads; t++) {
+		int first = t * chunk_size;
+		int last = first + chunk_size > num_pairs ? num_pairs : first + chunk_size;
+
+		chunks[t] = (struct batch_chunk_t) {
+			.polys = polys,
+			.pairs = pairs + 2*first,
+			.num_pairs = last - first > 0 ? last - first : 0,
+			.hits = hits + first,
+			.penetrations = penetrations == NULL ? NULL : penetrations + 2*first,
+			.options = options,
+			.statuses = statuses == NULL ? NULL : statuses + first,
+			.deadline_ns = deadline_ns,
+			.budget_iterations = budget_iterations,
+			.num_hits = 0,
+		};
+	}
+
+	// Chunk 0 runs on this thread. If a thread can't be started, its chunk runs here as well
+	for (int t = 1; t < num_threads; t++) {
+		started[t] = pthread_create(&threads[t], NULL, batch_collision_chunk, &chunks[t]) == 0;
+	}
+	batch_collision_chunk(&chunks[0]);
+
+	int num_hits = chunks[0].num_hits;
+	for (int t = 1; t < num_threads; t++) {
+		if (started[t]) {
+			pthread_join(threads[t], NULL);
+		} else {
+			batch_collision_chunk(&chunks[t]);
+		}
+		num_hits += chunks[t].num_hits;
+	}
+
+	return num_hits;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include "vector.h"
+#include "options.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Polygons packed back to back in flat arrays so they can be shared with other
+ * runtimes (e.g. JavaScript typed arrays on the wasm heap) without any copying.
+ *
+ * Polygon i owns vertices offsets[i] to offsets[i+1] - 1, so offsets has num_polygons + 1 entries.
+ * Vertex k is stored as coords[2*k], coords[2*k+1] = (x, y)
+ */
+struct batch_polygons_t {
+	const int32_t* coords;
+	const int32_t* offsets;
+	int num_polygons;
+};
+
+/**
+ * Checks every pair of polygons in pairs = (a0, b0, a1, b1, ...) for a collision.
+ *
+ * @param hits num_pairs entries that are set to 1 on collision and 0 otherwise
+ * @param penetrations NULL to skip EPA, otherwise 2*num_pairs entries that receive the penetration vector (x, y) of each pair. (0, 0) is written for pairs that don't collide.
+ * @return number of colliding pairs
+ */
+int batch_collision(struct batch_polygons_t polys, const int32_t* pairs, int num_pairs, uint8_t* hits, int32_t* penetrations);
+
+/**
+ * Same as batch_collision, but GJK and EPA use the limits in options, and pairs stop being checked once the batch is
+ * over options->budget_ns or options->budget_iterations. The remaining pairs are reported as not colliding.
+ *
+ * @param options NULL for QUERY_DEFAULT_OPTIONS
+ * @param statuses NULL, or num_pairs entries that receive the enum query_status_t of each pair
+ */
+int batch_collision_options(struct batch_polygons_t polys, const int32_t* pairs, int num_pairs, uint8_t* hits, int32_t* penetrations,
+		const struct query_options_t* options, uint8_t* statuses);
+
+#ifdef GJK_PTHREADS
+
+#ifndef BATCH_MAX_THREADS
+// For WebASM this must not be more than PTHREAD_POOL_SIZE + 1, since the browser can't start new workers while the main thread waits for them
+#define BATCH_MAX_THREADS 8
+#endif
+
+/**
+ * Same as batch_collision, but the pairs are split into contiguous chunks that are checked on num_threads threads at once.
+ * The calling thread checks one of the chunks itself. num_threads is clamped to [1, BATCH_MAX_THREADS].
+ */
+int batch_collision_parallel(struct batch_polygons_t polys, const int32_t* pairs, int num_pairs, uint8_t* hits, int32_t* penetrations, int num_threads);
+
+/**
+ * batch_collision_options on num_threads threads. Every thread has the whole time budget, since they run at the same
+ * time, and an equal share of the iteration budget
+ */
+int batch_collision_parallel_options(struct batch_polygons_t polys, const int32_t* pairs, int num_pairs, uint8_t* hits, int32_t* penetrations,
+		const struct query_options_t* options, uint8_t* statuses, int num_threads);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
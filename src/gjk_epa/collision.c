@@ -0,0 +1,49 @@
+#include "collision.h"
+
+static bool collide_with(struct polygon_t poly1, struct polygon_t poly2, struct vector_t d, const struct query_options_t* options,
+		struct collision_t* collision) {
+	collision->poly1 = poly1;
+	collision->poly2 = poly2;
+	collision->options = options;
+	collision->colliding = gjk_collision_generic(polygon_farthest_point, &poly1, polygon_farthest_point, &poly2, d, options,
+			&collision->simplex, &collision->gjk_iterations, &collision->status);
+	collision->has_penetration = false;
+	collision->penetration = (struct vector_t){0, 0};
+	collision->epa_iterations = 0;
+
+	return collision->colliding;
+}
+
+bool collide(struct polygon_t poly1, struct polygon_t poly2, struct collision_t* collision) {
+	return collide_with(poly1, poly2, sub(get_centroid(poly2), get_centroid(poly1)), NULL, collision);
+}
+
+bool collide_direction(struct polygon_t poly1, struct polygon_t poly2, struct vector_t d, struct collision_t* collision) {
+	return collide_with(poly1, poly2, d, NULL, collision);
+}
+
+bool collide_options(struct polygon_t poly1, struct polygon_t poly2, const struct query_options_t* options, struct collision_t* collision) {
+	return collide_with(poly1, poly2, sub(get_centroid(poly2), get_centroid(poly1)), options, collision);
+}
+
+struct vector_t collision_penetration(struct collision_t* collision) {
+	if (collision->colliding && !collision->has_penetration) {
+		collision->penetration = epa_from_simplex_options(collision->poly1, collision->poly2, &collision->simplex, NULL,
+				collision->options, &collision->epa_iterations, &collision->status);
+		collision->has_penetration = true;
+	}
+
+	return collision->penetration;
+}
+
+struct vector_t collision_penetration_cached(struct collision_t* collision, struct epa_cache_t* cache) {
+	if (!collision->colliding) {
+		epa_cache_reset(cache);
+	} else if (!collision->has_penetration) {
+		collision->penetration = epa_from_simplex_options(collision->poly1, collision->poly2, &collision->simplex, cache,
+				collision->options, &collision->epa_iterations, &collision->status);
+		collision->has_penetration = true;
+	}
+
+	return collision->penetration;
+}
@@ -0,0 +1,70 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <stdbool.h>
+#include "vector.h"
+#include "gjk.h"
+#include "epa.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Result of collide. Keeps the simplex GJK ended with so EPA can start from it later
+ */
+struct collision_t {
+	struct polygon_t poly1;
+	struct polygon_t poly2;
+	struct simplex_t simplex;
+	bool colliding;
+	bool has_penetration;
+	struct vector_t penetration;
+	int gjk_iterations;
+	int epa_iterations;
+	// QUERY_TRUNCATED if GJK or EPA hit one of the limits in options
+	enum query_status_t status;
+	// NULL for QUERY_DEFAULT_OPTIONS
+	const struct query_options_t* options;
+};
+
+/**
+ * Checks whether poly1 and poly2 collide with a single GJK run. Use collision_penetration
+ * afterwards if the penetration vector is needed as well.
+ *
+ * The polygons aren't changed or rescaled, but their points must stay valid until the last collision_penetration call
+ *
+ * @return true if there is a collision, false if no collision
+ */
+bool collide(struct polygon_t poly1, struct polygon_t poly2, struct collision_t* collision);
+
+/**
+ * Same as collide, but GJK starts searching in direction d instead of from poly1's centroid to poly2's.
+ * Lets callers that already know the centroids skip computing them again
+ */
+bool collide_direction(struct polygon_t poly1, struct polygon_t poly2, struct vector_t d, struct collision_t* collision);
+
+/**
+ * Same as collide, but GJK and the later EPA use the limits in options, which must stay valid as long as collision.
+ * collision->status tells whether they converged
+ */
+bool collide_options(struct polygon_t poly1, struct polygon_t poly2, const struct query_options_t* options, struct collision_t* collision);
+
+/**
+ * Runs EPA on the simplex from collide the first time it's called. Later calls return the same vector.
+ *
+ * @return penetration vector in fixed point like epa, or (0, 0) if there's no collision
+ */
+struct vector_t collision_penetration(struct collision_t* collision);
+
+/**
+ * Same as collision_penetration, but warm starts EPA from the pair's cache (see struct epa_cache_t).
+ * Keep one cache per pair of polygons across frames.
+ */
+struct vector_t collision_penetration_cached(struct collision_t* collision, struct epa_cache_t* cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
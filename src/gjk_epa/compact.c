@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <string.h>
+#include "compact.h"
+#include "error.h"
+
+#define INITIAL_SHAPES_CAPACITY 64
+#define INITIAL_POINTS_CAPACITY 1024
+
+void compact_init(struct compact_set_t* set, enum compact_width_t width) {
+	memset(set, 0, sizeof(struct compact_set_t));
+	set->width = width;
+}
+
+void compact_free(struct compact_set_t* set) {
+	if (!set->read_only) {
+		free(set->shapes);
+		free(set->points);
+	}
+	memset(set, 0, sizeof(struct compact_set_t));
+}
+
+static bool fits(scalar_t v, int width) {
+	if (width == COMPACT_INT16) {
+		return v >= INT16_MIN && v <= INT16_MAX;
+	}
+	return v >= INT32_MIN && v <= INT32_MAX;
+}
+
+static bool reserve(struct compact_set_t* set, int num_points) {
+	if (set->num_shapes == set->shapes_capacity) {
+		int capacity = set->shapes_capacity == 0 ? INITIAL_SHAPES_CAPACITY : 2 * set->shapes_capacity;
+
+		struct compact_entry_t* shapes = realloc(set->shapes, capacity * sizeof(struct compact_entry_t));
+		if (shapes == NULL) {
+			return false;
+		}
+		set->shapes = shapes;
+		set->shapes_capacity = capacity;
+	}
+
+	if (set->num_points + num_points > set->points_capacity) {
+		uint32_t capacity = set->points_capacity == 0 ? INITIAL_POINTS_CAPACITY : set->points_capacity;
+		while (set->num_points + num_points > capacity) {
+			capacity *= 2;
+		}
+
+		void* points = realloc(set->points, (size_t)capacity * 2 * set->width);
+		if (points == NULL) {
+			return false;
+		}
+		set->points = points;
+		set->points_capacity = capacity;
+	}
+
+	return true;
+}
+
+int compact_add(struct compact_set_t* set, struct polygon_t poly) {
+	if (set->read_only) {
+		LOG("ERROR: Can't add shapes to a read only compact set\n");
+		return -1;
+	}
+
+	struct aabb_t bounds = get_aabb(poly);
+	struct vector_t origin = {
+		bounds.min.x + (bounds.max.x - bounds.min.x) / 2,
+		bounds.min.y + (bounds.max.y - bounds.min.y) / 2,
+	};
+
+	if (!fits(bounds.min.x - origin.x, set->width) || !fits(bounds.max.x - origin.x, set->width)
+			|| !fits(bounds.min.y - origin.y, set->width) || !fits(bounds.max.y - origin.y, set->width)) {
+		LOG("ERROR: Shape is too big for %d bit points\n", 8 * set->width);
+		return -1;
+	}
+
+	if (!reserve(set, poly.num_points)) {
+		LOG("ERROR: Couldn't grow the compact set to %d shapes\n", set->num_shapes + 1);
+		return -1;
+	}
+
+	uint32_t first = set->num_points;
+	for (int i = 0; i < poly.num_points; i++) {
+		struct vector_t p = sub(poly.points[i], origin);
+		if (set->width == COMPACT_INT16) {
+			int16_t* points = (int16_t*)set->points + 2 * (first + i);
+			points[0] = (int16_t)p.x;
+			points[1] = (int16_t)p.y;
+		} else {
+			int32_t* points = (int32_t*)set->points + 2 * (first + i);
+			points[0] = (int32_t)p.x;
+			points[1] = (int32_t)p.y;
+		}
+	}
+
+	int id = set->num_shapes++;
+	set->shapes[id] = (struct compact_entry_t) {
+		.origin = origin,
+		.first = first,
+		.num_points = poly.num_points,
+		.min_x = bounds.min.x - origin.x,
+		.min_y = bounds.min.y - origin.y,
+		.max_x = bounds.max.x - origin.x,
+		.max_y = bounds.max.y - origin.y,
+	};
+	set->num_points += poly.num_points;
+
+	return id;
+}
+
+struct compact_shape_t compact_get(const struct compact_set_t* set, int id) {
+	const struct compact_entry_t* entry = &set->shapes[id];
+	return (struct compact_shape_t) {
+		.origin = entry->origin,
+		.points = (const char*)set->points + (size_t)entry->first * 2 * set->width,
+		.num_points = entry->num_points,
+		.width = set->width,
+	};
+}
+
+static struct vector_t widen(struct compact_shape_t shape, int i) {
+	struct vector_t p;
+	if (shape.width == COMPACT_INT16) {
+		const int16_t* points = shape.points;
+		p = (struct vector_t){points[2*i], points[2*i+1]};
+	} else {
+		const int32_t* points = shape.points;
+		p = (struct vector_t){points[2*i], points[2*i+1]};
+	}
+
+	p.x += shape.origin.x;
+	p.y += shape.origin.y;
+	return p;
+}
+
+struct polygon_t compact_unpack(struct compact_shape_t shape, struct vector_t* points) {
+	for (int i = 0; i < shape.num_points; i++) {
+		points[i] = widen(shape, i);
+	}
+	return (struct polygon_t){points, shape.num_points};
+}
+
+struct vector_t compact_farthest_point(const void* s, struct vector_t d) {
+	const struct compact_shape_t* shape = s;
+
+	// dot(origin + p, d) = dot(origin, d) + dot(p, d), so the farthest point only depends on the packed points.
+	// Ties go to the first point like get_farthest_point_in_direction
+	scalar_t max_dp;
+	int max_idx = 0;
+	if (shape->width == COMPACT_INT16) {
+		const int16_t* points = shape->points;
+		max_dp = points[0] * d.x + points[1] * d.y;
+		for (int i = 1; i < shape->num_points; i++) {
+			scalar_t dp = points[2*i] * d.x + points[2*i+1] * d.y;
+			if (dp > max_dp) {
+				max_dp = dp;
+				max_idx = i;
+			}
+		}
+	} else {
+		const int32_t* points = shape->points;
+		max_dp = points[0] * d.x + points[1] * d.y;
+		for (int i = 1; i < shape->num_points; i++) {
+			scalar_t dp = points[2*i] * d.x + points[2*i+1] * d.y;
+			if (dp > max_dp) {
+				max_dp = dp;
+				max_idx = i;
+			}
+		}
+	}
+
+	return widen(*shape, max_idx);
+}
+
+// Averages the packed points like get_centroid, only widening the sum
+static struct vector_t compact_centroid(struct compact_shape_t shape) {
+	struct vector_t sum = {0, 0};
+	for (int i = 0; i < shape.num_points; i++) {
+		if (shape.width == COMPACT_INT16) {
+			const int16_t* points = shape.points;
+			sum.x += points[2*i];
+			sum.y += points[2*i+1];
+		} else {
+			const int32_t* points = shape.points;
+			sum.x += points[2*i];
+			sum.y += points[2*i+1];
+		}
+	}
+
+	return (struct vector_t){shape.origin.x + sum.x / shape.num_points, shape.origin.y + sum.y / shape.num_points};
+}
+
+struct aabb_t compact_get_aabb(const struct compact_set_t* set, int id) {
+	const struct compact_entry_t* entry = &set->shapes[id];
+	return (struct aabb_t) {
+		{entry->origin.x + entry->min_x, entry->origin.y + entry->min_y},
+		{entry->origin.x + entry->max_x, entry->origin.y + entry->max_y},
+	};
+}
+
+bool compact_collision(const struct compact_set_t* set, int id, struct polygon_t poly, struct simplex_t* simplex) {
+	struct compact_shape_t shape = compact_get(set, id);
+	struct vector_t d = sub(get_centroid(poly), compact_centroid(shape));
+	return gjk_collision_generic(compact_farthest_point, &shape, polygon_farthest_point, &poly, d, NULL, simplex, NULL, NULL);
+}
+
+bool compact_collision_pair(struct compact_shape_t shape1, struct compact_shape_t shape2, struct simplex_t* simplex) {
+	struct vector_t d = sub(compact_centroid(shape2), compact_centroid(shape1));
+	return gjk_collision_generic(compact_farthest_point, &shape1, compact_farthest_point, &shape2, d, NULL, simplex, NULL, NULL);
+}
@@ -0,0 +1,118 @@
+/**
+ * Packed storage for large sets of static polygons
+ *
+ * A struct vector_t point takes 16 bytes, but static level geometry usually fits in much smaller coordinates.
+ * A compact set stores every point as a pair of int16 or int32 relative to its shape's origin, with the points of all
+ * the shapes in one contiguous array and an offset table to find each shape's points. The support function reads the
+ * packed points directly and only widens the farthest one, so GJK touches 4 or 8 bytes per point instead of 16.
+ *
+ * Shapes can't be changed once they're added.
+ */
+
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "vector.h"
+#include "gjk.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum compact_width_t {
+	COMPACT_INT16 = 2, // points up to +-32767 from the shape's origin
+	COMPACT_INT32 = 4,
+};
+
+/**
+ * Entry of the offset table. The origin and the bounds are kept next to the offset, so a query only misses the cache
+ * on the entry and on the points, and shapes whose bounds don't overlap can be skipped without reading their points
+ */
+struct compact_entry_t {
+	// Center of the shape's bounds, which its points are relative to
+	struct vector_t origin;
+	// Index of the shape's first point
+	uint32_t first;
+	uint32_t num_points;
+	// Bounds relative to the origin
+	int32_t min_x, min_y, max_x, max_y;
+};
+
+struct compact_set_t {
+	// Bytes per coordinate, one of enum compact_width_t
+	int width;
+
+	struct compact_entry_t* shapes;
+	int num_shapes;
+	int shapes_capacity;
+
+	// x and y of every point, interleaved
+	void* points;
+	uint32_t num_points;
+	uint32_t points_capacity;
+
+	// The arrays belong to someone else, like a mapped shape database (see shapedb.h), so shapes can't be added
+	// and compact_free leaves them alone
+	bool read_only;
+};
+
+/**
+ * A shape of a compact set, passed to compact_farthest_point or gjk_collision_generic
+ */
+struct compact_shape_t {
+	struct vector_t origin;
+	const void* points;
+	int num_points;
+	int width;
+};
+
+void compact_init(struct compact_set_t* set, enum compact_width_t width);
+
+void compact_free(struct compact_set_t* set);
+
+/**
+ * Packs a copy of poly's points
+ *
+ * @return id of the shape, or -1 if out of memory or a point is too far from the center of poly's bounds for the width
+ */
+int compact_add(struct compact_set_t* set, struct polygon_t poly);
+
+/**
+ * @return view of shape id, valid until the next compact_add
+ */
+struct compact_shape_t compact_get(const struct compact_set_t* set, int id);
+
+/**
+ * Widens the points of a shape back to a polygon
+ *
+ * @param points room for shape.num_points points
+ */
+struct polygon_t compact_unpack(struct compact_shape_t shape, struct vector_t* points);
+
+/**
+ * @return bounds of shape id, without reading its points
+ */
+struct aabb_t compact_get_aabb(const struct compact_set_t* set, int id);
+
+/**
+ * get_farthest_point_in_direction for a compact shape, as a farthest_point_fn taking a const struct compact_shape_t*
+ */
+struct vector_t compact_farthest_point(const void* shape, struct vector_t d);
+
+/**
+ * Same as gjk_collision between shape id of set and poly
+ */
+bool compact_collision(const struct compact_set_t* set, int id, struct polygon_t poly, struct simplex_t* simplex);
+
+/**
+ * Same as gjk_collision between two shapes of compact sets
+ */
+bool compact_collision_pair(struct compact_shape_t shape1, struct compact_shape_t shape2, struct simplex_t* simplex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
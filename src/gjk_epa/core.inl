@@ -0,0 +1,434 @@
+/**
+ * The GJK and EPA loops, parameterized on the support function of each shape
+ *
+ * gjk.c and epa.c build their entry points from these, and gjk.hpp builds its templates from them, so there is only
+ * one implementation of each algorithm. The loops are forced inline into their callers: when a caller passes a
+ * support function that's known at compile time, like gjk_core_polygon_support in gjk.c and epa.c or
+ * gjk_epa::farthest<T> in gjk.hpp, the compiler turns the calls through the farthest_point_fn into direct calls and
+ * can inline them, the same as a hand written copy for that shape type. Callers that only have function pointers at
+ * run time get the same code with indirect calls.
+ *
+ * Everything here is static, and written in the subset of C that is also C++, so it can be included from both.
+ */
+
+#ifndef CORE_INL
+#define CORE_INL
+
+#include <limits.h>
+#if defined(__wasm_simd128__) && !defined(GJK_NARROW_SCALAR)
+#include <wasm_simd128.h>
+#endif
+#include "vector.h"
+#include "fixed_point.h"
+#include "error.h"
+#include "options.h"
+#include "gjk.h"
+#include "epa.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GJK_CORE_INLINE static inline __attribute__((always_inline))
+#else
+#define GJK_CORE_INLINE static inline
+#endif
+
+// The cached directions are tilted from the normal by atan(1 / EPA_CACHE_TILT)
+#define EPA_CACHE_TILT 16
+
+enum {
+	CLOCKWISE,
+	COUNTERCLOCKWISE
+};
+
+/*
+ * Same as get_farthest_point_in_direction, which calls this
+ */
+GJK_CORE_INLINE struct vector_t gjk_core_polygon_farthest_point(struct polygon_t poly, struct vector_t d) {
+	scalar_t max_dp = dot(poly.points[0], d);
+	int max_idx = 0;
+	int i = 1;
+
+#if defined(__wasm_simd128__) && !defined(GJK_NARROW_SCALAR)
+	// Compute the dot products of two points at a time. Ties still go to the first point like the scalar loop
+	v128_t dx = wasm_i64x2_splat(d.x);
+	v128_t dy = wasm_i64x2_splat(d.y);
+	for (; i + 1 < poly.num_points; i += 2) {
+		v128_t p0 = wasm_v128_load(&poly.points[i]);   // (x_i, y_i)
+		v128_t p1 = wasm_v128_load(&poly.points[i+1]); // (x_i+1, y_i+1)
+		v128_t xs = wasm_i64x2_shuffle(p0, p1, 0, 2);
+		v128_t ys = wasm_i64x2_shuffle(p0, p1, 1, 3);
+		v128_t dps = wasm_i64x2_add(wasm_i64x2_mul(xs, dx), wasm_i64x2_mul(ys, dy));
+
+		int64_t dp0 = wasm_i64x2_extract_lane(dps, 0);
+		int64_t dp1 = wasm_i64x2_extract_lane(dps, 1);
+		if (dp0 > max_dp) {
+			max_dp = dp0;
+			max_idx = i;
+		}
+		if (dp1 > max_dp) {
+			max_dp = dp1;
+			max_idx = i + 1;
+		}
+	}
+#endif
+
+	for (; i < poly.num_points; i++) {
+		scalar_t dp = dot(poly.points[i], d);
+
+		if (dp > max_dp) {
+			max_dp = dp;
+			max_idx = i;
+		}
+	}
+
+	return poly.points[max_idx];
+}
+
+/*
+ * Same as polygon_farthest_point. gjk.c and epa.c pass this instead, since the compiler can only inline what it sees
+ */
+GJK_CORE_INLINE struct vector_t gjk_core_polygon_support(const void* poly, struct vector_t d) {
+	return gjk_core_polygon_farthest_point(*(const struct polygon_t*)poly, d);
+}
+
+// Support point of the minkowski difference of the two shapes
+GJK_CORE_INLINE struct vector_t gjk_core_support(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2,
+		const void* shape2, struct vector_t d) {
+	return sub(farthest1(shape1, d), farthest2(shape2, scalar_mult(-1, d)));
+}
+
+// Note this is for handling a triangular simplex, GJK works for arbitrary polygon
+static inline bool gjk_core_triangle_case(struct simplex_t* s, struct vector_t* d) {
+	struct vector_t c = s->points[0];
+	struct vector_t b = s->points[1];
+	struct vector_t a = s->points[2];
+
+	struct vector_t ab = sub(b, a);
+	struct vector_t ac = sub(c, a);
+	struct vector_t ao = scalar_mult(-1, a);
+
+	struct vector_t ab_perp = triple_product2(ac, ab, ab);
+	struct vector_t ac_perp = triple_product2(ab, ac, ac);
+
+	if (dot(ab_perp, ao) > 0) { // Region AB
+		*d = ab_perp;
+		enum simplex_error_t status = simplex_remove(0, s);
+		if (status == EMPTY_SIMPLEX) {
+			LOG("%s", simplex_error_string(status));
+		}
+
+		return false;
+	} else if (dot(ac_perp, ao) > 0) { // Region AC
+		*d = ac_perp;
+		enum simplex_error_t status = simplex_remove(1, s);
+		if (status == EMPTY_SIMPLEX) {
+			LOG("%s", simplex_error_string(status));
+		}
+		return false;
+	}
+	return true;
+}
+
+static inline bool gjk_core_line_case(struct simplex_t* s, struct vector_t* d) {
+	struct vector_t b = s->points[0];
+	struct vector_t a = s->points[1];
+
+	struct vector_t ab = sub(b, a);
+	struct vector_t ao = scalar_mult(-1, a);
+
+	struct vector_t ab_perp = triple_product2(ab, ao, ab);
+
+	// The origin is on the line through ab, so there's no side to pick. Either perpendicular finds the third point,
+	// instead of searching in a zero direction and ending up with a flat triangle
+	if (ab_perp.x == 0 && ab_perp.y == 0) {
+		ab_perp.x = -ab.y;
+		ab_perp.y = ab.x;
+	}
+
+	*d = ab_perp;
+	return false;
+}
+
+static inline bool gjk_core_contains_origin(struct simplex_t* s, struct vector_t* d) {
+	if (s->num_points == 2) {
+		return gjk_core_line_case(s, d);
+	}
+	return gjk_core_triangle_case(s, d);
+}
+
+/*
+ * Same as gjk_collision_generic, except that simplex can't be NULL
+ */
+GJK_CORE_INLINE bool gjk_core_collision(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2,
+		const void* shape2, struct vector_t d, const struct query_options_t* options, struct simplex_t* simplex, int* iterations,
+		enum query_status_t* query_status) {
+	int unused;
+	if (iterations == NULL) {
+		iterations = &unused;
+	}
+	enum query_status_t unused_status;
+	if (query_status == NULL) {
+		query_status = &unused_status;
+	}
+	if (options == NULL) {
+		options = &QUERY_DEFAULT_OPTIONS;
+	}
+	*query_status = QUERY_CONVERGED;
+
+	simplex->num_points = 0;
+
+	if (d.x == 0 && d.y == 0) {
+		// Same centroids, any direction works but zero doesn't
+		d.x = 1;
+	}
+
+	enum simplex_error_t status = simplex_add(gjk_core_support(farthest1, shape1, farthest2, shape2, d), simplex);
+	if (status == GJK_SIMPLEX_GREATER_THAN_3) {
+		LOG("%s", simplex_error_string(status));
+	}
+
+	// Search from the first point towards the origin. The line and triangle cases assume the origin is past
+	// the newest point's side of the simplex, which -d alone doesn't ensure when the origin is on the line
+	// through the first two points
+	if (simplex->points[0].x != 0 || simplex->points[0].y != 0) {
+		d = scalar_mult(-1, simplex->points[0]);
+	} else {
+		d = scalar_mult(-1, d);
+	}
+
+	for (*iterations = 1; *iterations <= options->max_gjk_iterations; (*iterations)++) {
+		struct vector_t A = gjk_core_support(farthest1, shape1, farthest2, shape2, d);
+
+		enum simplex_error_t status = simplex_add(A, simplex);
+		if (status == GJK_SIMPLEX_GREATER_THAN_3) {
+			LOG("%s", simplex_error_string(status));
+		}
+
+		if (dot(A, d) < 0) {
+			return false;
+		}
+
+		if (gjk_core_contains_origin(simplex, &d)) {
+			return true;
+		}
+	}
+
+	// If GJK doesn't converge after max_gjk_iterations, assume the polygons don't intersect
+	*iterations = options->max_gjk_iterations;
+	*query_status = QUERY_TRUNCATED;
+	return false;
+}
+
+// Based on https://dyn4j.org/2010/05/epa-expanding-polytope-algorithm/
+// and https://blog.hamaluik.ca/posts/building-a-collision-engine-part-2-2d-penetration-vectors/
+static inline struct edge_t epa_core_find_closest_edge(int winding, struct simplex_t* s) {
+	struct edge_t closest;
+	closest.distance = INT_MAX;
+	closest.normal.x = 0;
+	closest.normal.y = 0;
+	closest.index = -1;
+
+	for (int i = 0; i < s->num_points; i++) {
+		// compute the next points index
+		int j = i + 1 == s->num_points ? 0 : i + 1;
+		// get the current point and the next one
+		struct vector_t a = s->points[i];
+		struct vector_t b = s->points[j];
+		// create the edge vector
+		struct vector_t e = sub(b, a); // a to b;
+									   // get the vector from the origin to a
+									   // get the vector from the edge towards the origin
+		struct vector_t n;
+		if (winding == CLOCKWISE) {
+			// (y, -x)
+			n.x = -e.y;
+			n.y = e.x;
+		} else {
+			// (-y, x)
+			n.x = e.y;
+			n.y = -e.x;
+		}
+
+		// normalize the vector
+		n = normalize(n);
+		scalar_t d = fixed_point_to_int(dot(n, a));
+
+		// check the distance against the other distances.
+		// An edge through the origin still counts, since the origin often lands on one of the simplex's edges with integer points.
+		// Only repeated points, which have no normal, are skipped
+		if ((n.x != 0 || n.y != 0) && d < closest.distance) {
+			// if this edge is closer then use it
+			closest.distance = d;
+			closest.normal = n;
+			closest.index = j;
+		}
+
+	}
+	return closest;
+}
+
+// Support point of the fixed point minkowski difference. Scaling both shapes scales the support point, so the shapes can stay as integers
+GJK_CORE_INLINE struct vector_t epa_core_support(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2,
+		const void* shape2, struct vector_t d) {
+	struct vector_t p = gjk_core_support(farthest1, shape1, farthest2, shape2, d);
+	p.x = int_to_fixed_point(p.x);
+	p.y = int_to_fixed_point(p.y);
+	return p;
+}
+
+static inline bool epa_core_same_point(struct vector_t a, struct vector_t b) {
+	return a.x == b.x && a.y == b.y;
+}
+
+// Sign of the triangle's area. Same as the shoelace formula, but cross() doesn't overflow in narrow builds
+static inline int epa_core_winding(struct simplex_t* s) {
+	struct vector_t ab = sub(s->points[1], s->points[0]);
+	struct vector_t ac = sub(s->points[2], s->points[0]);
+	return (cross(ab, ac) <= 0) ? CLOCKWISE: COUNTERCLOCKWISE;
+}
+
+/*
+ * Keeps support() directions for next frame that find the ends of the closest edge, plus its normal.
+ * In the normal's direction every point of the edge is as far as the others, so it's tilted slightly towards each end.
+ * The points themselves aren't good directions: the farthest point towards a point on the edge is often some other point
+ */
+static inline void epa_core_cache_store(struct epa_cache_t* cache, struct simplex_t* s, struct edge_t e) {
+	int prev = e.index == 0 ? s->num_points - 1 : e.index - 1;
+	struct vector_t t = normalize(sub(s->points[e.index], s->points[prev]));
+	struct vector_t n = scalar_mult(EPA_CACHE_TILT, e.normal);
+
+	cache->directions[0] = sub(n, t);
+	cache->directions[1] = sub(n, scalar_mult(-1, t));
+	cache->normal = e.normal;
+	cache->valid = true;
+}
+
+/*
+ * Builds a triangle from the support points towards last frame's closest edge and away from its normal.
+ * If the contact hasn't changed, EPA finds that edge is still on the boundary in its first iteration.
+ * The triangle is only used if the origin is strictly inside it
+ */
+GJK_CORE_INLINE bool epa_core_cache_seed(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2,
+		const void* shape2, struct epa_cache_t* cache, struct simplex_t* simplex) {
+	if (!cache->valid) {
+		return false;
+	}
+
+	struct vector_t seed[3] = {
+		epa_core_support(farthest1, shape1, farthest2, shape2, cache->directions[0]),
+		epa_core_support(farthest1, shape1, farthest2, shape2, cache->directions[1]),
+		epa_core_support(farthest1, shape1, farthest2, shape2, scalar_mult(-1, cache->normal)),
+	};
+
+	scalar_t c0 = cross(seed[0], seed[1]);
+	scalar_t c1 = cross(seed[1], seed[2]);
+	scalar_t c2 = cross(seed[2], seed[0]);
+	if (c0 == 0 || c1 == 0 || c2 == 0 || (c0 > 0) != (c1 > 0) || (c1 > 0) != (c2 > 0)) {
+		return false;
+	}
+
+	for (int k = 0; k < 3; k++) {
+		simplex->points[k] = seed[k];
+	}
+	simplex->num_points = 3;
+
+	return true;
+}
+
+// Penetration vector of edge e, whose furthest support point is at distance d
+static inline struct vector_t epa_core_edge_penetration(struct edge_t e, scalar_t d) {
+	struct vector_t fp_result = scalar_mult(d, e.normal);
+	fp_result.x = fixed_point_to_int(fp_result.x);
+	fp_result.y = fixed_point_to_int(fp_result.y);
+	return fp_result;
+}
+
+GJK_CORE_INLINE struct vector_t epa_core_expand(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2,
+		const void* shape2, struct simplex_t* simplex, int* iterations, struct epa_cache_t* cache,
+		const struct query_options_t* options, enum query_status_t* status) {
+	int winding = epa_core_winding(simplex);
+	int max_simplex_size = options->max_simplex_size < MAX_SIMPLEX_SIZE ? options->max_simplex_size : MAX_SIMPLEX_SIZE;
+	*status = QUERY_CONVERGED;
+
+	struct edge_t e;
+	e.index = -1;
+	for (*iterations = 1; *iterations <= options->max_epa_iterations; (*iterations)++) {
+		e = epa_core_find_closest_edge(winding, simplex);
+		if (e.index < 0) {
+			// Every point is the same, so the polygons are only touching at one point
+			break;
+		}
+		struct vector_t p = epa_core_support(farthest1, shape1, farthest2, shape2, e.normal);
+
+		// dot product scaling_factor^2, so divide by scaling factor again to get back to fixed_point
+		scalar_t d = fixed_point_to_int(dot(p, e.normal));
+
+		// Getting one of the edge's own points back means the edge is on the boundary of the minkowski difference.
+		// The normal is rounded, so d - e.distance isn't always below tolerance when that happens
+		int prev = e.index == 0 ? simplex->num_points - 1 : e.index - 1;
+		bool on_boundary = epa_core_same_point(p, simplex->points[e.index]) || epa_core_same_point(p, simplex->points[prev]);
+
+		if (on_boundary || d - e.distance < options->tolerance || simplex->num_points >= max_simplex_size) {
+			if (!on_boundary && d - e.distance >= options->tolerance) {
+				*status = QUERY_TRUNCATED;
+			}
+			if (cache != NULL) {
+				epa_core_cache_store(cache, simplex, e);
+			}
+
+			return epa_core_edge_penetration(e, d);
+		} else {
+			simplex_insert(p, e.index, simplex);
+		}
+	}
+
+	if (*iterations > options->max_epa_iterations) {
+		*iterations = options->max_epa_iterations;
+		*status = QUERY_TRUNCATED;
+
+		// The closest edge of the polytope so far is the best guess, and the real boundary is at least as far
+		e = epa_core_find_closest_edge(winding, simplex);
+	}
+	if (cache != NULL) {
+		epa_cache_reset(cache);
+	}
+	if (*status == QUERY_TRUNCATED && e.index >= 0) {
+		return epa_core_edge_penetration(e, e.distance);
+	}
+	struct vector_t none = {0, 0};
+	return none;
+}
+
+/*
+ * Same as epa_from_simplex_generic
+ */
+GJK_CORE_INLINE struct vector_t epa_core_from_simplex(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2,
+		const void* shape2, struct simplex_t* simplex, struct epa_cache_t* cache, const struct query_options_t* options,
+		int* iterations, enum query_status_t* status) {
+	int unused;
+	if (iterations == NULL) {
+		iterations = &unused;
+	}
+	*iterations = 0;
+	enum query_status_t unused_status;
+	if (status == NULL) {
+		status = &unused_status;
+	}
+	*status = QUERY_CONVERGED;
+	if (options == NULL) {
+		options = &QUERY_DEFAULT_OPTIONS;
+	}
+
+	if (cache != NULL && epa_core_cache_seed(farthest1, shape1, farthest2, shape2, cache, simplex)) {
+		return epa_core_expand(farthest1, shape1, farthest2, shape2, simplex, iterations, cache, options, status);
+	}
+
+	// GJK works with integers since it only needs directions, and the fixed point products would overflow narrow scalars
+	for (int i = 0; i < simplex->num_points; i++) {
+		simplex->points[i].x = int_to_fixed_point(simplex->points[i].x);
+		simplex->points[i].y = int_to_fixed_point(simplex->points[i].y);
+	}
+
+	return epa_core_expand(farthest1, shape1, farthest2, shape2, simplex, iterations, cache, options, status);
+}
+
+#endif
@@ -2,18 +2,75 @@
 #define EPA_H
 
 #include "vector.h"
+#include "gjk.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Default EPA tolerance, see struct query_options_t
 #define TOLERANCE 1
 
+/**
+ * EPA state kept for a pair of polygons from one frame to the next, so that resting contacts can start
+ * from last frame's closest edge instead of the bare GJK simplex.
+ * Zero initialize it or call epa_cache_reset before the first use.
+ */
+struct epa_cache_t {
+	struct vector_t directions[2];
+	struct vector_t normal;
+	bool valid;
+};
+
 /**
  * @return penetration vector with information on depth and direction of collision
  */
 struct vector_t epa(struct polygon_t poly1, struct polygon_t poly2);
 
+/**
+ * Same as epa, but also stores how many times the polytope was expanded in `iterations` if it isn't NULL.
+ * iterations is 0 if the polygons don't collide
+ */
+struct vector_t epa_iterations(struct polygon_t poly1, struct polygon_t poly2, int* iterations);
+
+/**
+ * Runs EPA from the simplex that gjk_collision returned true with for the same polygons, so GJK doesn't have to run again.
+ * Unlike epa, the polygons aren't changed. The simplex is expanded in place.
+ *
+ * @param iterations stores how many times the polytope was expanded if it isn't NULL
+ */
+struct vector_t epa_from_simplex(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex, int* iterations);
+
+/**
+ * Same as epa_from_simplex, but first tries to start from the support points towards last frame's closest edge.
+ * Falls back to the simplex if those points don't surround the origin anymore.
+ * The cache is updated with this frame's result.
+ */
+struct vector_t epa_from_simplex_cached(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex, struct epa_cache_t* cache, int* iterations);
+
+/**
+ * Same as epa_from_simplex_cached, but with the limits in options
+ *
+ * @param cache NULL to always start from the simplex
+ * @param options NULL for QUERY_DEFAULT_OPTIONS. The budgets aren't used
+ * @param status receives QUERY_TRUNCATED if it isn't NULL and a limit stopped EPA before it converged
+ */
+struct vector_t epa_from_simplex_options(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex, struct epa_cache_t* cache,
+		const struct query_options_t* options, int* iterations, enum query_status_t* status);
+
+/**
+ * epa_from_simplex_options for shapes that are only read through their support functions, from the simplex that
+ * gjk_collision_generic returned true with for the same shapes
+ */
+struct vector_t epa_from_simplex_generic(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2, const void* shape2,
+		struct simplex_t* simplex, struct epa_cache_t* cache, const struct query_options_t* options, int* iterations,
+		enum query_status_t* status);
+
+/**
+ * Forgets the cached directions, e.g. when the polygons stop colliding
+ */
+void epa_cache_reset(struct epa_cache_t* cache);
+
 #ifdef __cplusplus
 }
 #endif
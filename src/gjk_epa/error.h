@@ -10,6 +10,10 @@
 #define LOG(fmt, ...) fprintf(stderr, (fmt), ##__VA_ARGS__)
 #endif
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 enum simplex_error_t {
 	GJK_SIMPLEX_GREATER_THAN_3=0,
 	SIMPLEX_REACHED_MAX_CAPACITY,
@@ -21,4 +25,8 @@ enum simplex_error_t {
 
 const char* simplex_error_string(enum simplex_error_t status);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -1,6 +1,6 @@
 #include "fixed_point.h"
 
-fixed_point_Q8_t int_to_fixed_point(int64_t i) {
+fixed_point_Q8_t int_to_fixed_point(scalar_t i) {
 	return i * FIXED_POINT_SCALING_FACTOR;
 }
 
@@ -14,10 +14,10 @@ void polygon_t_int_to_fixed_point(struct polygon_t P) {
 /** Truncates the fractional part
  * @return floor(f)
  */
-int64_t fixed_point_to_int(fixed_point_Q8_t f) {
+scalar_t fixed_point_to_int(fixed_point_Q8_t f) {
 	return f/FIXED_POINT_SCALING_FACTOR;
 }
 
-int64_t get_remainder(fixed_point_Q8_t f) {
+scalar_t get_remainder(fixed_point_Q8_t f) {
 	return f % FIXED_POINT_SCALING_FACTOR;
 }
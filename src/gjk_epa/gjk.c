@@ -8,10 +8,10 @@
  */
 
 #include <string.h>
-#include <alloca.h>
 #include "gjk.h"
 #include "fixed_point.h"
 #include "error.h"
+#include "core.inl"
 
 const struct vector_t ORIGIN = {
 	.x = 0,
@@ -76,19 +76,7 @@ struct polygon_t minkowski_diff(struct polygon_t poly1, struct polygon_t poly2,
 }
 
 struct vector_t get_farthest_point_in_direction(struct polygon_t poly, struct vector_t d) {
-	int64_t max_dp = dot(poly.points[0], d);
-	struct vector_t v = poly.points[0];
-
-	for (int i = 1; i < poly.num_points; i++) {
-		int64_t dp = dot(poly.points[i], d);
-
-		if (dp > max_dp) {
-			max_dp = dp;
-			v = poly.points[i];
-		}
-	}
-
-	return v;
+	return gjk_core_polygon_farthest_point(poly, d);
 }
 
 struct vector_t support(struct vector_t d, struct polygon_t poly1, struct polygon_t poly2) {
@@ -98,95 +86,33 @@ struct vector_t support(struct vector_t d, struct polygon_t poly1, struct polygo
 	return p3;
 }
 
-// Note this is for handling a triangular simplex, GJK works for arbitrary polygon
-bool triangle_case(struct simplex_t* s, struct vector_t* d) {
-	struct vector_t c =  s->points[0];
-	struct vector_t b = s->points[1];
-	struct vector_t a = s->points[2];
-
-	struct vector_t ab = sub(b, a);
-	struct vector_t ac = sub(c, a);
-	struct vector_t ao = sub(ORIGIN, a);
-
-	struct vector_t ab_perp = triple_product2(ac, ab, ab);
-	struct vector_t ac_perp = triple_product2(ab, ac, ac);
-
-	if (dot(ab_perp, ao) > 0) { // Region AB
-		*d = ab_perp;
-		enum simplex_error_t status = simplex_remove(0, s);
-		if (status == EMPTY_SIMPLEX) {
-			LOG("%s", simplex_error_string(status));
-		}
-
-		return false;
-	} else if (dot(ac_perp, ao) > 0) { // Region AC
-		*d = ac_perp;
-		enum simplex_error_t status = simplex_remove(1, s);
-		if (status == EMPTY_SIMPLEX) {
-			LOG("%s", simplex_error_string(status));
-		}
-		return false;
-	}
-	return true;
+bool gjk_collision(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex) { 
+	return gjk_collision_iterations(poly1, poly2, simplex, NULL);
 }
 
-bool line_case(struct simplex_t* s, struct vector_t* d) {
-	struct vector_t b = s->points[0];
-	struct vector_t a = s->points[1];
-
-	struct vector_t ab = sub(b, a);
-	struct vector_t ao = sub(ORIGIN, a);
-
-	struct vector_t ab_perp = triple_product2(ab, ao, ab);
-
-	*d = ab_perp;
-	return false;
+struct vector_t polygon_farthest_point(const void* poly, struct vector_t d) {
+	return get_farthest_point_in_direction(*(const struct polygon_t*)poly, d);
 }
 
-bool contains_origin(struct simplex_t* s, struct vector_t* d) {
-	if (s->num_points == 2) {
-		return line_case(s, d);
-	}
-	return triangle_case(s, d);
-}
-
-bool gjk_collision(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex) { 
-
-	if (simplex == NULL) {
-		simplex = alloca(sizeof(struct simplex_t));
-	}
-
-	simplex->num_points = 0;	
-
+bool gjk_collision_iterations(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex, int* iterations) {
 	// direction d to check = poly2.center - poly1.center
 	/* struct vector_t d = (struct vector_t) {.x=1, .y=0}; */
 	struct vector_t d = sub(get_centroid(poly2), get_centroid(poly1));
+	return gjk_collision_generic(polygon_farthest_point, &poly1, polygon_farthest_point, &poly2, d, NULL, simplex, iterations, NULL);
+}
 
-	enum simplex_error_t status = simplex_add(support(d, poly1, poly2), simplex);
-	if (status == GJK_SIMPLEX_GREATER_THAN_3) {
-		LOG("%s", simplex_error_string(status));
+bool gjk_collision_generic(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2, const void* shape2,
+		struct vector_t d, const struct query_options_t* options, struct simplex_t* simplex, int* iterations,
+		enum query_status_t* query_status) {
+	struct simplex_t unused;
+	if (simplex == NULL) {
+		simplex = &unused;
 	}
 
-	/* d = sub(ORIGIN, simplex.points[0]); */
-	d = sub(ORIGIN, d);
-
-	for (int iterations = 0; iterations < MAX_ITERATIONS; iterations++) {
-		struct vector_t A = support(d, poly1, poly2);
-
-		enum simplex_error_t status = simplex_add(A, simplex);
-		if (status == GJK_SIMPLEX_GREATER_THAN_3) {
-			LOG("%s", simplex_error_string(status));
-		}
-
-		if (dot(A, d) < 0) {
-			return false;
-		}
-
-		if (contains_origin(simplex, &d)) {
-			return true;
-		}
+	// Most callers pass two polygons, which get a copy of the loop with the support calls inlined
+	if (farthest1 == polygon_farthest_point && farthest2 == polygon_farthest_point) {
+		return gjk_core_collision(gjk_core_polygon_support, shape1, gjk_core_polygon_support, shape2, d, options, simplex, iterations,
+				query_status);
 	}
-
-	// If GJK doesn't converge after MAX_ITERATIONS, assume the polygons don't intersect
-	return false;
+	return gjk_core_collision(farthest1, shape1, farthest2, shape2, d, options, simplex, iterations, query_status);
 }
@@ -4,12 +4,13 @@
 #include <stdbool.h>
 #include "vector.h"
 #include "error.h"
+#include "options.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// I just chose numbers that looked good
+// I just chose numbers that looked good. These are the defaults, see struct query_options_t for limits per call
 #define MAX_ITERATIONS 1000
 
 // Defines how fine the resolution of the simplex becomes for EPA when finding 
@@ -61,6 +62,40 @@ struct vector_t support(struct vector_t d, struct polygon_t poly1, struct polygo
  */
 bool gjk_collision(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex);
 
+/**
+ * Same as gjk_collision, but also stores how many iterations GJK took in `iterations` if it isn't NULL
+ */
+bool gjk_collision_iterations(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex, int* iterations);
+
+/**
+ * Support function of a single polygon, the first one of its points with the largest dot product with d
+ */
+struct vector_t get_farthest_point_in_direction(struct polygon_t poly, struct vector_t d);
+
+/**
+ * Support function of a single shape, see get_farthest_point_in_direction
+ *
+ * @return point of shape farthest in direction d
+ */
+typedef struct vector_t (*farthest_point_fn)(const void* shape, struct vector_t d);
+
+/**
+ * get_farthest_point_in_direction as a farthest_point_fn taking a const struct polygon_t*
+ */
+struct vector_t polygon_farthest_point(const void* poly, struct vector_t d);
+
+/**
+ * gjk_collision_iterations for shapes that aren't stored as a struct polygon_t, like the packed shapes in compact.h.
+ * Each shape is only read through its support function
+ *
+ * @param d first search direction, usually from the centroid of shape1 to the centroid of shape2
+ * @param options NULL for QUERY_DEFAULT_OPTIONS. Only max_gjk_iterations is used
+ * @param query_status receives QUERY_TRUNCATED if it isn't NULL and GJK ran out of iterations, QUERY_CONVERGED otherwise
+ */
+bool gjk_collision_generic(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2, const void* shape2,
+		struct vector_t d, const struct query_options_t* options, struct simplex_t* simplex, int* iterations,
+		enum query_status_t* query_status);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,76 @@
+/**
+ * Header only C++ layer over gjk.h and epa.h
+ *
+ * gjk_epa::collision and gjk_epa::penetration take shapes of any type instead of a farthest_point_fn and a void
+ * pointer for each. They instantiate the GJK and EPA loops of core.inl, the same ones gjk.c and epa.c are built from,
+ * with gjk_epa::farthest<T> as the support function of each shape type. That function is known at compile time, so
+ * the support calls are inlined into each instantiation instead of going through a function pointer.
+ *
+ * Any type can be a shape by declaring this next to it, where argument dependent lookup finds it:
+ *     struct vector_t farthest_point(const T& shape, struct vector_t d);
+ * Define it inline in a header for the support calls to be inlined as well.
+ * struct polygon_t and struct compact_shape_t already have one.
+ */
+
+#ifndef GJK_HPP
+#define GJK_HPP
+
+#include "vector.h"
+#include "gjk.h"
+#include "epa.h"
+#include "compact.h"
+#include "core.inl"
+
+namespace gjk_epa {
+
+/**
+ * Same as get_farthest_point_in_direction
+ */
+inline struct vector_t farthest_point(const struct polygon_t& poly, struct vector_t d) {
+	return gjk_core_polygon_farthest_point(poly, d);
+}
+
+/**
+ * Same as compact_farthest_point
+ */
+inline struct vector_t farthest_point(const struct compact_shape_t& shape, struct vector_t d) {
+	return compact_farthest_point(&shape, d);
+}
+
+/**
+ * farthest_point of a T as a farthest_point_fn taking a const T*
+ */
+template <class T>
+struct vector_t farthest(const void* shape, struct vector_t d) {
+	return farthest_point(*static_cast<const T*>(shape), d);
+}
+
+/**
+ * Same as gjk_collision_generic
+ *
+ * @param d first search direction, usually from the centroid of shape1 to the centroid of shape2
+ */
+template <class Shape1, class Shape2>
+bool collision(const Shape1& shape1, const Shape2& shape2, struct vector_t d, struct simplex_t* simplex = nullptr,
+		const struct query_options_t* options = nullptr, int* iterations = nullptr, enum query_status_t* status = nullptr) {
+	struct simplex_t unused;
+	if (simplex == nullptr) {
+		simplex = &unused;
+	}
+	return gjk_core_collision(farthest<Shape1>, &shape1, farthest<Shape2>, &shape2, d, options, simplex, iterations, status);
+}
+
+/**
+ * Same as epa_from_simplex_generic, from the simplex that collision returned true with for the same shapes
+ *
+ * @return penetration vector in fixed point, like epa
+ */
+template <class Shape1, class Shape2>
+struct vector_t penetration(const Shape1& shape1, const Shape2& shape2, struct simplex_t* simplex, struct epa_cache_t* cache = nullptr,
+		const struct query_options_t* options = nullptr, int* iterations = nullptr, enum query_status_t* status = nullptr) {
+	return epa_core_from_simplex(farthest<Shape1>, &shape1, farthest<Shape2>, &shape2, simplex, cache, options, iterations, status);
+}
+
+}
+
+#endif
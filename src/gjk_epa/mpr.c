@@ -0,0 +1,188 @@
+#include <string.h>
+#include "mpr.h"
+#include "fixed_point.h"
+#include "epa.h"
+
+struct mpr_shapes_t {
+	farthest_point_fn farthest1;
+	const void* shape1;
+	farthest_point_fn farthest2;
+	const void* shape2;
+};
+
+static struct vector_t mpr_support(const struct mpr_shapes_t* s, struct vector_t d) {
+	return sub(s->farthest1(s->shape1, d), s->farthest2(s->shape2, scalar_mult(-1, d)));
+}
+
+static struct vector_t perp(struct vector_t v) {
+	return (struct vector_t){-v.y, v.x};
+}
+
+static bool same_point(struct vector_t a, struct vector_t b) {
+	return a.x == b.x && a.y == b.y;
+}
+
+/*
+ * Whether the ray from v0 through the origin is on the same side of the line from v0 through v as point p.
+ * A ray on the line counts as the same side
+ */
+static bool ray_on_side_of(struct vector_t v0, struct vector_t v, struct vector_t p) {
+	struct vector_t dir = sub(v, v0);
+	scalar_t ray = cross(dir, scalar_mult(-1, v0));
+	return ray == 0 || (ray > 0) == (cross(dir, sub(p, v0)) > 0);
+}
+
+// Normal of the portal pointing away from v0, not normalized
+static struct vector_t portal_normal(struct vector_t v0, struct vector_t v1, struct vector_t v2) {
+	struct vector_t n = perp(sub(v2, v1));
+	return dot(n, sub(v1, v0)) < 0 ? scalar_mult(-1, n) : n;
+}
+
+/*
+ * Finds the first portal, two support points on either side of the ray from v0 through the origin
+ *
+ * @return false if a support point shows that the origin is outside
+ */
+static bool find_portal(const struct mpr_shapes_t* s, struct vector_t v0, struct vector_t* v1, struct vector_t* v2,
+		int max_iterations, int* iterations) {
+	*v1 = mpr_support(s, scalar_mult(-1, v0));
+	if (dot(*v1, v0) > 0) {
+		return false;
+	}
+
+	for (; *iterations < max_iterations; (*iterations)++) {
+		// Towards the origin's side of the line from v0 through v1
+		struct vector_t n = perp(sub(*v1, v0));
+		if (dot(n, v0) > 0) {
+			n = scalar_mult(-1, n);
+		}
+
+		*v2 = mpr_support(s, n);
+		if (same_point(*v2, *v1)) {
+			// The origin is on the line, so either side works, but this one has no other point
+			n = scalar_mult(-1, n);
+			*v2 = mpr_support(s, n);
+		}
+		if (dot(*v2, n) < 0) {
+			return false;
+		}
+
+		// The ray can pass v2 on the far side, then v2 takes v1's place and the search turns further
+		if (ray_on_side_of(v0, *v2, *v1)) {
+			return true;
+		}
+		*v1 = *v2;
+	}
+
+	return false;
+}
+
+/*
+ * Fills in the result with epa's penetration when the centers are the same
+ */
+static bool same_center_depth(const struct mpr_shapes_t* s, struct vector_t d, const struct query_options_t* options,
+		struct mpr_result_t* result) {
+	struct simplex_t simplex;
+	if (!gjk_collision_generic(s->farthest1, s->shape1, s->farthest2, s->shape2, d, options, &simplex, &result->iterations,
+			&result->status)) {
+		// Only when GJK runs out of iterations
+		return true;
+	}
+
+	result->penetration = epa_from_simplex_generic(s->farthest1, s->shape1, s->farthest2, s->shape2, &simplex, NULL, options,
+			&result->depth_iterations, &result->status);
+	result->normal = normalize(result->penetration);
+	result->depth = fixed_point_to_int(dot(result->penetration, result->normal));
+	return true;
+}
+
+bool mpr_collision_generic(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2, const void* shape2,
+		struct vector_t d, const struct query_options_t* options, struct mpr_result_t* result) {
+	bool find_depth = result != NULL;
+	struct mpr_result_t unused;
+	if (result == NULL) {
+		result = &unused;
+	}
+	if (options == NULL) {
+		options = &QUERY_DEFAULT_OPTIONS;
+	}
+	memset(result, 0, sizeof(struct mpr_result_t));
+	result->status = QUERY_CONVERGED;
+
+	const struct mpr_shapes_t s = {farthest1, shape1, farthest2, shape2};
+
+	// Inside the minkowski difference
+	struct vector_t v0 = scalar_mult(-1, d);
+	if (v0.x == 0 && v0.y == 0) {
+		// The centers are the same, so the origin is inside and the shapes overlap. There's no ray to cast, and a point
+		// next to the center isn't always inside thin shapes, so the depth comes from epa instead
+		return !find_depth || same_center_depth(&s, d, options, result);
+	}
+
+	struct vector_t v1, v2;
+	if (!find_portal(&s, v0, &v1, &v2, options->max_gjk_iterations, &result->iterations)) {
+		if (result->iterations >= options->max_gjk_iterations) {
+			result->status = QUERY_TRUNCATED;
+		}
+		return false;
+	}
+
+	bool hit = false;
+	struct vector_t n;
+	for (;;) {
+		n = portal_normal(v0, v1, v2);
+		if (!hit && dot(v1, n) >= 0) {
+			// The origin is behind the portal
+			hit = true;
+			if (!find_depth) {
+				return true;
+			}
+		}
+
+		if (hit ? result->depth_iterations >= options->max_epa_iterations : result->iterations >= options->max_gjk_iterations) {
+			result->status = QUERY_TRUNCATED;
+			break;
+		}
+		if (hit) {
+			result->depth_iterations++;
+		} else {
+			result->iterations++;
+		}
+
+		struct vector_t v3 = mpr_support(&s, n);
+		if (!hit && dot(v3, n) < 0) {
+			return false;
+		}
+
+		// The portal is on the boundary when nothing is farther out in its normal's direction
+		bool on_boundary = same_point(v3, v1) || same_point(v3, v2) || dot(sub(v3, v1), n) <= 0;
+		if (!hit && on_boundary) {
+			return false;
+		}
+		if (hit && (on_boundary || dot(sub(v3, v1), normalize(n)) < options->tolerance)) {
+			break;
+		}
+
+		// Keep the half of the portal that the ray passes through
+		if (ray_on_side_of(v0, v3, v1)) {
+			v2 = v3;
+		} else {
+			v1 = v3;
+		}
+	}
+
+	if (!hit) {
+		return false;
+	}
+
+	result->normal = normalize(n);
+	result->depth = dot(v1, result->normal);
+	struct vector_t fp_penetration = scalar_mult(result->depth, result->normal);
+	result->penetration = (struct vector_t){fixed_point_to_int(fp_penetration.x), fixed_point_to_int(fp_penetration.y)};
+	return true;
+}
+
+bool mpr_collision(struct polygon_t poly1, struct polygon_t poly2, struct mpr_result_t* result) {
+	struct vector_t d = sub(get_centroid(poly2), get_centroid(poly1));
+	return mpr_collision_generic(polygon_farthest_point, &poly1, polygon_farthest_point, &poly2, d, NULL, result);
+}
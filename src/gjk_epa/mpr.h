@@ -0,0 +1,64 @@
+/**
+ * Minkowski Portal Refinement (XenoCollide) for 2D, over the same support functions as GJK
+ *
+ * MPR casts a ray from a point inside the minkowski difference (the difference of the centers) towards the origin,
+ * and refines the portal, the edge between two support points that the ray passes through. The shapes collide if the
+ * origin is behind the portal. Refining further until the portal is on the boundary gives a normal and depth, but along
+ * the ray instead of the shortest way out, so they're only close to epa's when the centers are lined up with the contact,
+ * e.g. shapes resting on each other. Good for trigger volumes, where a rough push direction is enough.
+ *
+ * Based on http://xenocollide.snethen.com/mpr2d.html
+ */
+
+#ifndef MPR_H
+#define MPR_H
+
+#include <stdbool.h>
+#include "vector.h"
+#include "gjk.h"
+#include "options.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct mpr_result_t {
+	// Approximate penetration vector in fixed point like epa's, normal scaled by depth. (0, 0) without a collision
+	struct vector_t penetration;
+	// Outward normal of the last portal, normalized in fixed point
+	struct vector_t normal;
+	// Distance from the origin to the last portal, in fixed point
+	scalar_t depth;
+	// Portal refinements to find the collision, and to find the depth
+	int iterations;
+	int depth_iterations;
+	// QUERY_TRUNCATED if a limit stopped MPR before it converged
+	enum query_status_t status;
+};
+
+/**
+ * Checks whether poly1 and poly2 collide, and finds an approximate penetration if result isn't NULL.
+ * Touching counts as a collision, like gjk_collision
+ *
+ * @param result NULL when only the answer is needed, which stops as soon as the origin is behind the portal
+ * @return true if there is a collision, false if no collision
+ */
+bool mpr_collision(struct polygon_t poly1, struct polygon_t poly2, struct mpr_result_t* result);
+
+/**
+ * mpr_collision for shapes that are only read through their support functions, like gjk_collision_generic
+ *
+ * @param d from the center of shape1 to the center of shape2. -d has to be inside the minkowski difference, which
+ *          holds for centroids and the centers of bounds. When it's (0, 0) the shapes overlap, and the penetration,
+ *          normal and depth come from epa since there's no ray to cast
+ * @param options NULL for QUERY_DEFAULT_OPTIONS. max_gjk_iterations limits the search for the collision,
+ *                max_epa_iterations and tolerance the refinement of the depth
+ */
+bool mpr_collision_generic(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2, const void* shape2,
+		struct vector_t d, const struct query_options_t* options, struct mpr_result_t* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,12 @@
+#include "options.h"
+#include "gjk.h"
+#include "epa.h"
+
+const struct query_options_t QUERY_DEFAULT_OPTIONS = {
+	.max_gjk_iterations = MAX_ITERATIONS,
+	.max_epa_iterations = MAX_ITERATIONS,
+	.max_simplex_size = MAX_SIMPLEX_SIZE,
+	.tolerance = TOLERANCE,
+	.budget_ns = 0,
+	.budget_iterations = 0,
+};
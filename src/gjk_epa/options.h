@@ -0,0 +1,51 @@
+/**
+ * Runtime limits for GJK, EPA and batches of queries
+ *
+ * The functions without options use MAX_ITERATIONS, MAX_SIMPLEX_SIZE and TOLERANCE. Lower limits bound the time one
+ * pathological pair can take, at the cost of accuracy on the pairs that hit them, which report QUERY_TRUNCATED.
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdint.h>
+#include "vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum query_status_t {
+	QUERY_CONVERGED=0,
+	// A limit stopped the query early. GJK reports no collision, and EPA the closest edge it had found, which is
+	// never deeper than the real penetration
+	QUERY_TRUNCATED,
+	// The batch ran out of budget before the pair was checked, so it reports no collision
+	QUERY_SKIPPED,
+};
+
+struct query_options_t {
+	int max_gjk_iterations;
+	int max_epa_iterations;
+	// EPA stops expanding at this many points, at most MAX_SIMPLEX_SIZE
+	int max_simplex_size;
+	// EPA stops once the next support point is less than this much past the closest edge, in fixed point like the
+	// penetration vector
+	scalar_t tolerance;
+
+	// Budgets for a whole batch, 0 for no limit. They're checked before every pair, so the pair that runs over still finishes
+	int64_t budget_ns;
+	// GJK and EPA iterations together
+	long budget_iterations;
+};
+
+/**
+ * Same limits as the functions without options, and no budget
+ */
+extern const struct query_options_t QUERY_DEFAULT_OPTIONS;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+#include <alloca.h>
+#include "query.h"
+#include "gjk.h"
+#include "collision.h"
+
+// Loads the next candidate into the cache while the current one is tested. The points of each candidate are usually
+// somewhere else in memory, so the hardware prefetcher can't guess them
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(p) __builtin_prefetch(p)
+#else
+#define PREFETCH(p)
+#endif
+
+void query_prepare(struct query_shape_t* query, struct polygon_t poly) {
+	query->poly = poly;
+	query->centroid = get_centroid(poly);
+	query->bounds = get_aabb(poly);
+}
+
+// get_aabb and get_centroid in one pass over the points
+static struct aabb_t bounds_and_centroid(struct polygon_t poly, struct vector_t* centroid) {
+	struct vector_t sum = poly.points[0];
+	struct aabb_t box = {poly.points[0], poly.points[0]};
+
+	for (int i = 1; i < poly.num_points; i++) {
+		struct vector_t p = poly.points[i];
+		sum.x += p.x;
+		sum.y += p.y;
+		if (p.x < box.min.x) box.min.x = p.x;
+		if (p.y < box.min.y) box.min.y = p.y;
+		if (p.x > box.max.x) box.max.x = p.x;
+		if (p.y > box.max.y) box.max.y = p.y;
+	}
+
+	*centroid = (struct vector_t){sum.x / poly.num_points, sum.y / poly.num_points};
+	return box;
+}
+
+// Runs GJK from the centroids, and EPA too if penetration isn't NULL
+static bool collide_candidate(const struct query_shape_t* query, struct polygon_t candidate, struct vector_t centroid,
+		struct vector_t* penetration) {
+	struct vector_t d = sub(centroid, query->centroid);
+
+	if (penetration == NULL) {
+		return gjk_collision_generic(polygon_farthest_point, &query->poly, polygon_farthest_point, &candidate, d, NULL, NULL, NULL, NULL);
+	}
+
+	struct collision_t collision;
+	bool colliding = collide_direction(query->poly, candidate, d, &collision);
+	*penetration = collision_penetration(&collision);
+	return colliding;
+}
+
+int query_collision(const struct query_shape_t* query, const struct polygon_t* candidates, int num_candidates,
+		int max_hits, bool penetrations, struct query_hit_t* hits) {
+	int num_hits = 0;
+
+	for (int i = 0; i < num_candidates && num_hits < max_hits; i++) {
+		if (i + 1 < num_candidates) {
+			PREFETCH(candidates[i + 1].points);
+		}
+
+		struct vector_t centroid;
+		if (!aabb_overlap(query->bounds, bounds_and_centroid(candidates[i], &centroid))) {
+			continue;
+		}
+
+		struct vector_t penetration = {0, 0};
+		if (collide_candidate(query, candidates[i], centroid, penetrations ? &penetration : NULL)) {
+			hits[num_hits++] = (struct query_hit_t){i, penetration};
+		}
+	}
+
+	return num_hits;
+}
+
+// EPA needs a struct polygon_t, so the candidate is widened first when the penetration is needed.
+// Separate function so the alloca'd points are freed after every candidate
+static bool collide_compact_candidate(const struct query_shape_t* query, struct compact_shape_t shape, struct vector_t* penetration) {
+	// The center of the bounds is close enough to the centroid to start GJK from, without reading the points
+	struct vector_t centroid = shape.origin;
+
+	if (penetration == NULL) {
+		struct vector_t d = sub(centroid, query->centroid);
+		return gjk_collision_generic(polygon_farthest_point, &query->poly, compact_farthest_point, &shape, d, NULL, NULL, NULL, NULL);
+	}
+
+	struct polygon_t candidate = compact_unpack(shape, alloca(shape.num_points * sizeof(struct vector_t)));
+	return collide_candidate(query, candidate, centroid, penetration);
+}
+
+int query_compact_collision(const struct query_shape_t* query, const struct compact_set_t* set, const int* ids, int num_ids,
+		int max_hits, bool penetrations, struct query_hit_t* hits) {
+	int num_hits = 0;
+	for (int i = 0; i < num_ids && num_hits < max_hits; i++) {
+		if (i + 1 < num_ids) {
+			PREFETCH(&set->shapes[ids[i + 1]]);
+		}
+
+		if (!aabb_overlap(query->bounds, compact_get_aabb(set, ids[i]))) {
+			continue;
+		}
+
+		struct vector_t penetration = {0, 0};
+		if (collide_compact_candidate(query, compact_get(set, ids[i]), penetrations ? &penetration : NULL)) {
+			hits[num_hits++] = (struct query_hit_t){ids[i], penetration};
+		}
+	}
+
+	return num_hits;
+}
@@ -0,0 +1,67 @@
+/**
+ * Tests one moving shape (a player, a projectile, a selection area) against many candidates
+ *
+ * The query shape's centroid and bounds are computed once by query_prepare instead of once per candidate.
+ * Each candidate is read in a single pass that finds both its bounds and its centroid, so candidates whose bounds
+ * don't overlap the query's are rejected without running GJK, and the others start GJK from the centroids.
+ * Candidates are visited in the order they're given, and the search can stop after the first few hits.
+ */
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <stdbool.h>
+#include <limits.h>
+#include "vector.h"
+#include "compact.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// max_hits that checks every candidate. Use 1 to stop at the first hit
+#define QUERY_ALL_HITS INT_MAX
+
+/**
+ * Query shape with what every candidate test needs precomputed. The points of poly must stay valid while it's used
+ */
+struct query_shape_t {
+	struct polygon_t poly;
+	struct vector_t centroid;
+	struct aabb_t bounds;
+};
+
+struct query_hit_t {
+	// Index of the candidate in the array, or its id in the compact set
+	int index;
+	// Like collision_penetration(query, candidate), or (0, 0) if penetrations weren't asked for
+	struct vector_t penetration;
+};
+
+void query_prepare(struct query_shape_t* query, struct polygon_t poly);
+
+/**
+ * Finds the candidates that collide with the query, in the order of the array
+ *
+ * @param max_hits stops after this many hits, QUERY_ALL_HITS to check every candidate
+ * @param penetrations whether to run EPA on the hits
+ * @param hits room for min(max_hits, num_candidates) hits
+ * @return number of hits written
+ */
+int query_collision(const struct query_shape_t* query, const struct polygon_t* candidates, int num_candidates,
+		int max_hits, bool penetrations, struct query_hit_t* hits);
+
+/**
+ * Same as query_collision for shapes of a compact set, visited in the order of ids. Shapes are stored in the order
+ * they were added, so sorted ids walk through the set's memory in one direction
+ *
+ * @return number of hits written
+ */
+int query_compact_collision(const struct query_shape_t* query, const struct compact_set_t* set, const int* ids, int num_ids,
+		int max_hits, bool penetrations, struct query_hit_t* hits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
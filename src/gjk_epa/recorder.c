@@ -0,0 +1,423 @@
+// The calculator has no files to record to
+#ifndef TI84PCE
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef GJK_PTHREADS
+#include <pthread.h>
+#include <time.h>
+#endif
+#include "recorder.h"
+#include "epa.h"
+#include "fixed_point.h"
+#include "error.h"
+
+#define RECORDER_MAGIC "GJKR"
+#define HEADER_SIZE (4 + 2 + 2 + 2 + 4)
+#define RECORD_FIXED_SIZE (1 + 1 + 4 + 2 + 2 + 4 + 4 + 4 + 4 + 4 + 4)
+#define POINT_SIZE (4 + 4)
+// How long the writer thread sleeps when the buffer isn't half full yet
+#define WRITER_INTERVAL_MS 100
+
+/*
+ * Ring buffer of records. Queries write their record in at head, and the writer takes the used bytes before it out
+ * to the file. used only goes down once they're written, so queries never overwrite bytes that are being written
+ */
+static struct {
+	FILE* file;
+	uint8_t* buffer;
+	size_t size;
+	size_t head;
+	size_t used;
+	// Read without the lock, by every recorded query for active and by recorder_dropped at any time
+	atomic_long dropped;
+	atomic_bool active;
+#ifdef GJK_PTHREADS
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_t writer;
+	bool writer_running;
+	bool stopping;
+#endif
+} recorder = {0};
+
+static void lock(void) {
+#ifdef GJK_PTHREADS
+	pthread_mutex_lock(&recorder.lock);
+#endif
+}
+
+static void unlock(void) {
+#ifdef GJK_PTHREADS
+	pthread_mutex_unlock(&recorder.lock);
+#endif
+}
+
+static uint8_t* put_u16(uint8_t* p, uint16_t v) {
+	p[0] = v & 0xFF;
+	p[1] = (v >> 8) & 0xFF;
+	return p + 2;
+}
+
+static uint8_t* put_i32(uint8_t* p, int32_t v) {
+	uint32_t u = (uint32_t)v;
+	p[0] = u & 0xFF;
+	p[1] = (u >> 8) & 0xFF;
+	p[2] = (u >> 16) & 0xFF;
+	p[3] = (u >> 24) & 0xFF;
+	return p + 4;
+}
+
+static const uint8_t* get_u16(const uint8_t* p, uint16_t* v) {
+	*v = (uint16_t)(p[0] | (p[1] << 8));
+	return p + 2;
+}
+
+static const uint8_t* get_i32(const uint8_t* p, int32_t* v) {
+	*v = (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+	return p + 4;
+}
+
+// Writes out everything in the buffer. Only one thread drains at a time: the writer, or the caller of recorder_flush without one
+static void drain(void) {
+	for (;;) {
+		lock();
+		size_t used = recorder.used;
+		size_t tail = (recorder.head + recorder.size - used) % recorder.size;
+		unlock();
+		if (used == 0) {
+			return;
+		}
+
+		// Up to the end of the buffer, the rest comes around in the next chunk
+		size_t chunk = used < recorder.size - tail ? used : recorder.size - tail;
+		fwrite(recorder.buffer + tail, 1, chunk, recorder.file);
+
+		lock();
+		recorder.used -= chunk;
+		unlock();
+	}
+}
+
+#ifdef GJK_PTHREADS
+static void* writer_main(void* arg) {
+	(void)arg;
+
+	lock();
+	while (!recorder.stopping) {
+		if (recorder.used < recorder.size / 2) {
+			struct timespec until;
+			clock_gettime(CLOCK_REALTIME, &until);
+			until.tv_nsec += WRITER_INTERVAL_MS * 1000000L;
+			until.tv_sec += until.tv_nsec / 1000000000L;
+			until.tv_nsec %= 1000000000L;
+			pthread_cond_timedwait(&recorder.wake, &recorder.lock, &until);
+		}
+		unlock();
+		drain();
+		lock();
+	}
+	unlock();
+
+	drain();
+	return NULL;
+}
+#endif
+
+void recorder_flush(void) {
+	if (!recorder_active()) {
+		return;
+	}
+
+#ifdef GJK_PTHREADS
+	if (recorder.writer_running) {
+		lock();
+		pthread_cond_signal(&recorder.wake);
+		unlock();
+		return;
+	}
+#endif
+	drain();
+}
+
+bool recorder_start(const char* path, size_t buffer_size) {
+	if (recorder.file != NULL) {
+		return false;
+	}
+
+	if (buffer_size == 0) {
+		buffer_size = RECORDER_DEFAULT_BUFFER_SIZE;
+	}
+
+	recorder.file = fopen(path, "wb");
+	if (recorder.file == NULL) {
+		LOG("ERROR: Couldn't open %s for recording\n", path);
+		return false;
+	}
+
+	recorder.buffer = malloc(buffer_size);
+	if (recorder.buffer == NULL) {
+		fclose(recorder.file);
+		recorder.file = NULL;
+		return false;
+	}
+	recorder.size = buffer_size;
+	recorder.head = 0;
+	recorder.used = 0;
+	atomic_store(&recorder.dropped, 0);
+
+	uint8_t header[HEADER_SIZE];
+	uint8_t* p = header;
+	memcpy(p, RECORDER_MAGIC, 4);
+	p = put_u16(p + 4, RECORDER_VERSION);
+	p = put_u16(p, MAX_ITERATIONS);
+	p = put_u16(p, MAX_SIMPLEX_SIZE);
+	put_i32(p, TOLERANCE);
+	fwrite(header, 1, HEADER_SIZE, recorder.file);
+
+#ifdef GJK_PTHREADS
+	pthread_mutex_init(&recorder.lock, NULL);
+	pthread_cond_init(&recorder.wake, NULL);
+	recorder.stopping = false;
+	// Without the thread, records wait in the buffer for recorder_flush like in single threaded builds
+	recorder.writer_running = pthread_create(&recorder.writer, NULL, writer_main, NULL) == 0;
+#endif
+
+	atomic_store(&recorder.active, true);
+	return true;
+}
+
+void recorder_stop(void) {
+	if (recorder.file == NULL) {
+		return;
+	}
+	atomic_store(&recorder.active, false);
+
+#ifdef GJK_PTHREADS
+	if (recorder.writer_running) {
+		lock();
+		recorder.stopping = true;
+		pthread_cond_signal(&recorder.wake);
+		unlock();
+		pthread_join(recorder.writer, NULL);
+		recorder.writer_running = false;
+	}
+#endif
+	drain();
+
+	long dropped = recorder_dropped();
+	if (dropped > 0) {
+		LOG("WARNING: %ld queries didn't fit in the recorder's buffer and weren't recorded\n", dropped);
+	}
+
+	fclose(recorder.file);
+	free(recorder.buffer);
+#ifdef GJK_PTHREADS
+	pthread_cond_destroy(&recorder.wake);
+	pthread_mutex_destroy(&recorder.lock);
+#endif
+
+	recorder.file = NULL;
+	recorder.buffer = NULL;
+	recorder.size = 0;
+}
+
+bool recorder_active(void) {
+	return atomic_load(&recorder.active);
+}
+
+long recorder_dropped(void) {
+	return atomic_load(&recorder.dropped);
+}
+
+// Copies bytes into the ring buffer at `at`, wrapping around its end
+static size_t put_ring(size_t at, const uint8_t* bytes, size_t size) {
+	size_t first = size < recorder.size - at ? size : recorder.size - at;
+	memcpy(recorder.buffer + at, bytes, first);
+	memcpy(recorder.buffer, bytes + first, size - first);
+	return (at + size) % recorder.size;
+}
+
+static size_t put_polygon(size_t at, struct polygon_t poly) {
+	for (int i = 0; i < poly.num_points; i++) {
+		uint8_t point[POINT_SIZE];
+		put_i32(put_i32(point, poly.points[i].x), poly.points[i].y);
+		at = put_ring(at, point, POINT_SIZE);
+	}
+	return at;
+}
+
+/*
+ * Writes a record straight into the buffer, or drops it if the writer hasn't made room for it yet.
+ * Only the points are converted under the lock, the rest is put together before taking it
+ */
+static void record(enum recorder_query_t type, struct polygon_t poly1, struct polygon_t poly2, const struct query_options_t* options,
+		bool colliding, int iterations, struct vector_t penetration) {
+	size_t size = RECORD_FIXED_SIZE + (size_t)(poly1.num_points + poly2.num_points) * POINT_SIZE;
+	if (options == NULL) {
+		options = &QUERY_DEFAULT_OPTIONS;
+	}
+
+	uint8_t fixed[RECORD_FIXED_SIZE];
+	uint8_t* p = fixed;
+	*p++ = type;
+	*p++ = colliding;
+	p = put_i32(p, iterations);
+	p = put_u16(p, poly1.num_points);
+	p = put_u16(p, poly2.num_points);
+	p = put_i32(p, penetration.x);
+	p = put_i32(p, penetration.y);
+	p = put_i32(p, options->max_gjk_iterations);
+	p = put_i32(p, options->max_epa_iterations);
+	p = put_i32(p, options->max_simplex_size);
+	put_i32(p, options->tolerance);
+
+	lock();
+	if (size > recorder.size - recorder.used) {
+		atomic_fetch_add(&recorder.dropped, 1);
+		unlock();
+		return;
+	}
+
+	put_polygon(put_polygon(put_ring(recorder.head, fixed, RECORD_FIXED_SIZE), poly1), poly2);
+	recorder.head = (recorder.head + size) % recorder.size;
+	recorder.used += size;
+
+#ifdef GJK_PTHREADS
+	if (recorder.used >= recorder.size / 2) {
+		pthread_cond_signal(&recorder.wake);
+	}
+#endif
+	unlock();
+}
+
+bool recorded_gjk_collision(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex) {
+	if (!recorder_active()) {
+		return gjk_collision(poly1, poly2, simplex);
+	}
+
+	int iterations;
+	bool colliding = gjk_collision_iterations(poly1, poly2, simplex, &iterations);
+	record(RECORD_GJK_COLLISION, poly1, poly2, NULL, colliding, iterations, (struct vector_t){0, 0});
+
+	return colliding;
+}
+
+struct vector_t recorded_epa(struct polygon_t poly1, struct polygon_t poly2) {
+	if (!recorder_active()) {
+		return epa(poly1, poly2);
+	}
+
+	// epa_iterations without rescaling the polygons at the end, so the record gets the points as they were passed in
+	int iterations = 0;
+	struct vector_t penetration = {0, 0};
+	struct simplex_t simplex = {
+		.num_points = 0
+	};
+	if (gjk_collision(poly1, poly2, &simplex)) {
+		penetration = epa_from_simplex(poly1, poly2, &simplex, &iterations);
+	}
+
+	record(RECORD_EPA, poly1, poly2, NULL, iterations > 0, iterations, penetration);
+
+	polygon_t_int_to_fixed_point(poly1);
+	polygon_t_int_to_fixed_point(poly2);
+	return penetration;
+}
+
+bool recorded_collide(struct polygon_t poly1, struct polygon_t poly2, struct collision_t* collision) {
+	return recorded_collide_options(poly1, poly2, NULL, collision);
+}
+
+bool recorded_collide_options(struct polygon_t poly1, struct polygon_t poly2, const struct query_options_t* options,
+		struct collision_t* collision) {
+	bool colliding = collide_options(poly1, poly2, options, collision);
+
+	if (recorder_active()) {
+		struct vector_t penetration = collision_penetration(collision);
+		record(RECORD_COLLIDE, poly1, poly2, options, colliding, collision->gjk_iterations + collision->epa_iterations, penetration);
+	}
+
+	return colliding;
+}
+
+bool recorder_read_header(FILE* f, struct recorder_header_t* header) {
+	uint8_t buffer[HEADER_SIZE];
+	if (fread(buffer, 1, HEADER_SIZE, f) != HEADER_SIZE || memcmp(buffer, RECORDER_MAGIC, 4) != 0) {
+		return false;
+	}
+
+	const uint8_t* p = get_u16(buffer + 4, &header->version);
+	p = get_u16(p, &header->max_iterations);
+	p = get_u16(p, &header->max_simplex_size);
+	get_i32(p, &header->tolerance);
+
+	return header->version == RECORDER_VERSION;
+}
+
+static bool read_polygon(FILE* f, int num_points, struct polygon_t* poly, int* capacity) {
+	if (num_points > *capacity) {
+		struct vector_t* points = realloc(poly->points, num_points * sizeof(struct vector_t));
+		if (points == NULL) {
+			return false;
+		}
+		poly->points = points;
+		*capacity = num_points;
+	}
+	poly->num_points = num_points;
+
+	for (int i = 0; i < num_points; i++) {
+		uint8_t buffer[POINT_SIZE];
+		if (fread(buffer, 1, POINT_SIZE, f) != POINT_SIZE) {
+			return false;
+		}
+
+		int32_t x, y;
+		get_i32(get_i32(buffer, &x), &y);
+		poly->points[i] = (struct vector_t){x, y};
+	}
+
+	return true;
+}
+
+bool recorder_read_query(FILE* f, struct recorded_query_t* query) {
+	uint8_t buffer[RECORD_FIXED_SIZE];
+	if (fread(buffer, 1, RECORD_FIXED_SIZE, f) != RECORD_FIXED_SIZE || buffer[0] >= NUM_RECORD_QUERY_TYPES) {
+		return false;
+	}
+
+	uint16_t num_points1, num_points2;
+	int32_t iterations, x, y, max_gjk_iterations, max_epa_iterations, max_simplex_size, tolerance;
+	const uint8_t* p = get_i32(buffer + 2, &iterations);
+	p = get_u16(p, &num_points1);
+	p = get_u16(p, &num_points2);
+	p = get_i32(p, &x);
+	p = get_i32(p, &y);
+	p = get_i32(p, &max_gjk_iterations);
+	p = get_i32(p, &max_epa_iterations);
+	p = get_i32(p, &max_simplex_size);
+	get_i32(p, &tolerance);
+
+	query->type = buffer[0];
+	query->colliding = buffer[1];
+	query->iterations = iterations;
+	query->penetration = (struct vector_t){x, y};
+	query->options = QUERY_DEFAULT_OPTIONS;
+	query->options.max_gjk_iterations = max_gjk_iterations;
+	query->options.max_epa_iterations = max_epa_iterations;
+	query->options.max_simplex_size = max_simplex_size;
+	query->options.tolerance = tolerance;
+
+	return read_polygon(f, num_points1, &query->poly1, &query->capacity1)
+		&& read_polygon(f, num_points2, &query->poly2, &query->capacity2);
+}
+
+void recorded_query_free(struct recorded_query_t* query) {
+	free(query->poly1.points);
+	free(query->poly2.points);
+	query->poly1.points = query->poly2.points = NULL;
+	query->capacity1 = query->capacity2 = 0;
+}
+
+#endif
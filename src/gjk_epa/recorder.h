@@ -0,0 +1,139 @@
+/**
+ * Records gjk_collision and epa queries to a binary log, so that a slow session can be replayed and profiled offline (see tools/replay.c)
+ *
+ * Log format (all integers are little endian):
+ *   header: "GJKR", u16 version, u16 MAX_ITERATIONS, u16 MAX_SIMPLEX_SIZE, i32 TOLERANCE of the recording build
+ *   record: u8 query type, u8 colliding, i32 iterations, u16 poly1.num_points, u16 poly2.num_points,
+ *           i32 penetration.x, i32 penetration.y,
+ *           i32 max_gjk_iterations, i32 max_epa_iterations, i32 max_simplex_size, i32 tolerance of the query's options,
+ *           (i32 x, i32 y) for every point of poly1 and then poly2
+ *
+ * Points are stored as they were passed in, before epa rescales them.
+ *
+ * Queries only copy their record into a ring buffer, without allocating. With GJK_PTHREADS a background thread writes the
+ * buffer to the file, otherwise call recorder_flush between frames. A record that doesn't fit in the free space is dropped
+ * instead of waiting for the file (see recorder_dropped), so make the buffer bigger if that happens.
+ * With GJK_PTHREADS queries can be recorded from several threads, but recorder_start and recorder_stop aren't thread safe.
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "vector.h"
+#include "gjk.h"
+#include "collision.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RECORDER_VERSION 3
+
+// Size of the ring buffer. The writer thread empties it when it's half full, and every 100 ms
+#define RECORDER_DEFAULT_BUFFER_SIZE (1 << 20)
+
+enum recorder_query_t {
+	RECORD_GJK_COLLISION=0,
+	RECORD_EPA,
+	RECORD_COLLIDE,
+
+	NUM_RECORD_QUERY_TYPES
+};
+
+struct recorder_header_t {
+	uint16_t version;
+	uint16_t max_iterations;
+	uint16_t max_simplex_size;
+	int32_t tolerance;
+};
+
+/**
+ * A query read back from a log. The points arrays are owned by the caller and are grown by recorder_read_query as needed
+ */
+struct recorded_query_t {
+	enum recorder_query_t type;
+	bool colliding;
+	int iterations;
+	struct vector_t penetration;
+	// Limits the query ran with. The budgets aren't recorded and are 0
+	struct query_options_t options;
+	struct polygon_t poly1;
+	struct polygon_t poly2;
+	int capacity1;
+	int capacity2;
+};
+
+/**
+ * Starts recording every recorded_gjk_collision and recorded_epa call to the file at path
+ *
+ * @param buffer_size bytes to buffer in memory before writing to the file. 0 uses RECORDER_DEFAULT_BUFFER_SIZE
+ * @return false if the file couldn't be opened or a recording is already running
+ */
+bool recorder_start(const char* path, size_t buffer_size);
+
+/**
+ * Writes out any buffered records and closes the log
+ */
+void recorder_stop(void);
+
+/**
+ * Writes out the buffered records. Call it outside of the queries, e.g. once per frame. With GJK_PTHREADS it only wakes
+ * the writer thread up
+ */
+void recorder_flush(void);
+
+bool recorder_active(void);
+
+/**
+ * @return number of queries that weren't recorded because the buffer was full
+ */
+long recorder_dropped(void);
+
+/**
+ * gjk_collision that also records the query if a recording is running
+ */
+bool recorded_gjk_collision(struct polygon_t poly1, struct polygon_t poly2, struct simplex_t* simplex);
+
+/**
+ * epa that also records the query if a recording is running
+ */
+struct vector_t recorded_epa(struct polygon_t poly1, struct polygon_t poly2);
+
+/**
+ * collide that also records the query if a recording is running.
+ * While recording, the penetration is computed right away so it can go in the log, and iterations are GJK's plus EPA's
+ */
+bool recorded_collide(struct polygon_t poly1, struct polygon_t poly2, struct collision_t* collision);
+
+/**
+ * collide_options that also records the query with its options if a recording is running
+ */
+bool recorded_collide_options(struct polygon_t poly1, struct polygon_t poly2, const struct query_options_t* options,
+		struct collision_t* collision);
+
+/**
+ * Reads and checks the header at the start of a log
+ */
+bool recorder_read_header(FILE* f, struct recorder_header_t* header);
+
+/**
+ * Reads the next query from a log
+ *
+ * @return false at the end of the log or if the record is truncated
+ */
+bool recorder_read_query(FILE* f, struct recorded_query_t* query);
+
+/**
+ * Frees the points arrays allocated by recorder_read_query
+ */
+void recorded_query_free(struct recorded_query_t* query);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
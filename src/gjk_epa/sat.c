@@ -0,0 +1,112 @@
+#include "sat.h"
+#include "fixed_point.h"
+
+int sat_normals(struct polygon_t poly, struct vector_t* normals) {
+	int num_normals = 0;
+
+	for (int i = 0; i < poly.num_points; i++) {
+		int j = i + 1 == poly.num_points ? 0 : i + 1;
+		struct vector_t e = sub(poly.points[j], poly.points[i]);
+		struct vector_t n = {-e.y, e.x};
+
+		bool parallel = n.x == 0 && n.y == 0;
+		for (int k = 0; k < num_normals && !parallel; k++) {
+			parallel = cross(n, normals[k]) == 0;
+		}
+
+		if (!parallel) {
+			normals[num_normals++] = n;
+		}
+	}
+
+	return num_normals;
+}
+
+static void project(struct polygon_t poly, struct vector_t axis, scalar_t* min, scalar_t* max) {
+	*min = *max = dot(poly.points[0], axis);
+
+	for (int i = 1; i < poly.num_points; i++) {
+		scalar_t d = dot(poly.points[i], axis);
+		if (d < *min) *min = d;
+		if (d > *max) *max = d;
+	}
+}
+
+// True if one of the axes separates the polygons
+static bool separated(struct polygon_t poly1, struct polygon_t poly2, const struct vector_t* axes, int num_axes) {
+	for (int i = 0; i < num_axes; i++) {
+		scalar_t min1, max1, min2, max2;
+		project(poly1, axes[i], &min1, &max1);
+		project(poly2, axes[i], &min2, &max2);
+
+		if (max1 < min2 || max2 < min1) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool sat_collision(struct polygon_t poly1, const struct vector_t* normals1, int num_normals1,
+		struct polygon_t poly2, const struct vector_t* normals2, int num_normals2) {
+	return !separated(poly1, poly2, normals1, num_normals1) && !separated(poly1, poly2, normals2, num_normals2);
+}
+
+/*
+ * Finds the axis with the least overlap. depth is in fixed point along the normalized axis, and sign says which way
+ * poly1 sticks into poly2
+ *
+ * @return false if one of the axes separates the polygons
+ */
+static bool least_overlap(struct polygon_t poly1, struct polygon_t poly2, const struct vector_t* axes, int num_axes,
+		scalar_t* depth, struct vector_t* axis, int* sign) {
+	for (int i = 0; i < num_axes; i++) {
+		scalar_t min1, max1, min2, max2;
+		project(poly1, axes[i], &min1, &max1);
+		project(poly2, axes[i], &min2, &max2);
+
+		if (max1 < min2 || max2 < min1) {
+			return false;
+		}
+
+		// The exact axis decides the answer, like sat_collision. The depth is measured again along the normalized
+		// axis, which is scaled to fixed point first since normalizing a short edge's normal would round its direction
+		struct vector_t n = normalize(scalar_mult(FIXED_POINT_SCALING_FACTOR, axes[i]));
+		project(poly1, n, &min1, &max1);
+		project(poly2, n, &min2, &max2);
+
+		scalar_t forward = max1 - min2;
+		scalar_t backward = max2 - min1;
+		scalar_t d = forward <= backward ? forward : backward;
+		if (d < 0) {
+			// Touching along the exact axis, and rounding moved them apart
+			d = 0;
+		}
+
+		if (*depth < 0 || d < *depth) {
+			*depth = d;
+			*axis = n;
+			*sign = forward <= backward ? 1 : -1;
+		}
+	}
+
+	return true;
+}
+
+bool sat_penetration(struct polygon_t poly1, const struct vector_t* normals1, int num_normals1,
+		struct polygon_t poly2, const struct vector_t* normals2, int num_normals2, struct vector_t* penetration) {
+	*penetration = (struct vector_t){0, 0};
+
+	scalar_t depth = -1;
+	struct vector_t axis = {0, 0};
+	int sign = 1;
+	if (!least_overlap(poly1, poly2, normals1, num_normals1, &depth, &axis, &sign) ||
+			!least_overlap(poly1, poly2, normals2, num_normals2, &depth, &axis, &sign)) {
+		return false;
+	}
+
+	// Same units as epa: the normal and the depth are in fixed point, and so is their product after one conversion back
+	struct vector_t fp_penetration = scalar_mult(sign * (depth < 0 ? 0 : depth), axis);
+	*penetration = (struct vector_t){fixed_point_to_int(fp_penetration.x), fixed_point_to_int(fp_penetration.y)};
+	return true;
+}
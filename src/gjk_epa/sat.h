@@ -0,0 +1,54 @@
+/**
+ * Separating axis test for convex polygons
+ *
+ * Two convex polygons don't collide only if one of their edge normals is an axis that separates them.
+ * The normals only depend on the edges, so they're computed once per shape and stay valid while the shape only moves,
+ * but not when it rotates or changes shape.
+ */
+
+#ifndef SAT_H
+#define SAT_H
+
+#include <stdbool.h>
+#include "vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Computes the normals of poly's edges, leaving out normals parallel to one already found (e.g. a rectangle only has two).
+ * They aren't normalized, so they're exact
+ *
+ * @param normals room for poly.num_points normals
+ * @return number of normals written
+ */
+int sat_normals(struct polygon_t poly, struct vector_t* normals);
+
+/**
+ * Checks whether poly1 and poly2 are intersecting. Touching counts as a collision, like gjk_collision.
+ * Both polygons have to be convex, since only their own edges are tried as axes
+ *
+ * @param normals1 normals of poly1 from sat_normals
+ * @param normals2 normals of poly2 from sat_normals
+ * @return true if there is a collision, false if no collision
+ */
+bool sat_collision(struct polygon_t poly1, const struct vector_t* normals1, int num_normals1,
+		struct polygon_t poly2, const struct vector_t* normals2, int num_normals2);
+
+/**
+ * sat_collision that also finds the penetration vector from the axis where the polygons overlap the least,
+ * which for convex polygons is the shortest way out, like epa. Its units and sign are epa's: fixed point, and moving
+ * poly1 by -penetration separates the polygons
+ *
+ * @param penetration receives the penetration vector, (0, 0) if they don't collide
+ * @return true if there is a collision, false if no collision
+ */
+bool sat_penetration(struct polygon_t poly1, const struct vector_t* normals1, int num_normals1,
+		struct polygon_t poly2, const struct vector_t* normals2, int num_normals2, struct vector_t* penetration);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+#include "shape.h"
+#include "sat.h"
+#include "gjk.h"
+#include "mpr.h"
+#include "collision.h"
+
+static bool is_box(struct polygon_t poly) {
+	if (poly.num_points != 4) {
+		return false;
+	}
+
+	// Every edge is horizontal or vertical, alternating
+	for (int i = 0; i < 4; i++) {
+		struct vector_t e = sub(poly.points[(i + 1) % 4], poly.points[i]);
+		struct vector_t next = sub(poly.points[(i + 2) % 4], poly.points[(i + 1) % 4]);
+		bool horizontal = e.y == 0 && e.x != 0;
+		bool vertical = e.x == 0 && e.y != 0;
+		bool next_horizontal = next.y == 0 && next.x != 0;
+		if (!(horizontal || vertical) || horizontal == next_horizontal) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void shape_init(struct shape_t* shape, struct polygon_t poly) {
+	shape->poly = poly;
+	shape->num_normals = 0;
+
+	if (is_box(poly)) {
+		shape->kind = SHAPE_BOX;
+	} else if (poly.num_points <= SHAPE_SMALL_POLYGON_POINTS) {
+		shape->kind = SHAPE_SMALL_POLYGON;
+	} else {
+		shape->kind = SHAPE_POLYGON;
+		return;
+	}
+
+	shape->num_normals = sat_normals(poly, shape->normals);
+}
+
+static bool box_box(const struct shape_t* a, const struct shape_t* b) {
+	return aabb_overlap(get_aabb(a->poly), get_aabb(b->poly));
+}
+
+static bool sat(const struct shape_t* a, const struct shape_t* b) {
+	return sat_collision(a->poly, a->normals, a->num_normals, b->poly, b->normals, b->num_normals);
+}
+
+static bool mpr(const struct shape_t* a, const struct shape_t* b) {
+	return mpr_collision(a->poly, b->poly, NULL);
+}
+
+static const shape_collision_fn COLLISION_TESTS[NUM_SHAPE_KINDS][NUM_SHAPE_KINDS] = {
+	//                     SHAPE_BOX  SHAPE_SMALL_POLYGON  SHAPE_POLYGON
+	[SHAPE_BOX]           = {box_box, sat,                 mpr},
+	[SHAPE_SMALL_POLYGON] = {sat,     sat,                 mpr},
+	[SHAPE_POLYGON]       = {mpr,     mpr,                 mpr},
+};
+
+shape_collision_fn shape_collision_test(enum shape_kind_t kind1, enum shape_kind_t kind2) {
+	return COLLISION_TESTS[kind1][kind2];
+}
+
+bool shape_collision(const struct shape_t* a, const struct shape_t* b, struct vector_t* penetration) {
+	if (penetration == NULL) {
+		return COLLISION_TESTS[a->kind][b->kind](a, b);
+	}
+
+	// Boxes and small polygons have their normals, and their axis of least overlap is the shortest way out.
+	// MPR's depth is along the line between the centers, so polygons run GJK for EPA's simplex instead
+	if (a->kind != SHAPE_POLYGON && b->kind != SHAPE_POLYGON) {
+		return sat_penetration(a->poly, a->normals, a->num_normals, b->poly, b->normals, b->num_normals, penetration);
+	}
+
+	struct collision_t collision;
+	bool colliding = collide(a->poly, b->poly, &collision);
+	*penetration = collision_penetration(&collision);
+	return colliding;
+}
@@ -0,0 +1,72 @@
+/**
+ * Picks the fastest boolean collision test for a pair of shapes from their kinds:
+ *
+ *                 box            small polygon   polygon
+ *   box           bounds         SAT             MPR
+ *   small polygon SAT            SAT             MPR
+ *   polygon       MPR            MPR             MPR
+ *
+ * Every test counts touching as a collision, so the answer doesn't depend on which one runs.
+ * Penetration vectors come from SAT's axis of least overlap when neither shape is a polygon, and from EPA otherwise.
+ */
+
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <stdbool.h>
+#include "vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SAT projects both polygons on every axis, so it gets slower than GJK as the polygons grow. `bench dispatch`, ns/query:
+//   n=4 gjk 133 sat 86, box gjk 127 sat 80, n=5 gjk 147 sat 182, n=6 gjk 150 sat 170, n=7 gjk 160 sat 311
+// Bigger polygons use MPR, which only needs to get the origin behind its portal instead of building a simplex around it:
+//   n=8 gjk 148 mpr 135, n=12 gjk 210 mpr 170, n=16 gjk 254 mpr 201
+#define SHAPE_SMALL_POLYGON_POINTS 4
+
+enum shape_kind_t {
+	SHAPE_BOX=0,         // axis aligned rectangle
+	SHAPE_SMALL_POLYGON, // at most SHAPE_SMALL_POLYGON_POINTS points
+	SHAPE_POLYGON,
+
+	NUM_SHAPE_KINDS
+};
+
+/**
+ * A convex polygon with what the collision tests for its kind need precomputed.
+ * The normals stay valid while the polygon only moves. Call shape_init again after rotating or reshaping it
+ */
+struct shape_t {
+	struct polygon_t poly;
+	enum shape_kind_t kind;
+	struct vector_t normals[SHAPE_SMALL_POLYGON_POINTS];
+	int num_normals;
+};
+
+typedef bool (*shape_collision_fn)(const struct shape_t* a, const struct shape_t* b);
+
+/**
+ * Picks the kind of poly and precomputes its SAT normals if it's small enough
+ */
+void shape_init(struct shape_t* shape, struct polygon_t poly);
+
+/**
+ * @return collision test used for a pair of shapes of these kinds
+ */
+shape_collision_fn shape_collision_test(enum shape_kind_t kind1, enum shape_kind_t kind2);
+
+/**
+ * Checks whether two shapes collide with the test for their kinds
+ *
+ * @param penetration NULL to skip finding the penetration, otherwise receives the penetration vector like collision_penetration, (0, 0) if they don't collide
+ * @return true if there is a collision, false if no collision
+ */
+bool shape_collision(const struct shape_t* a, const struct shape_t* b, struct vector_t* penetration);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,189 @@
+#include <stdint.h>
+#include <string.h>
+#ifndef TI84PCE
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "shapedb.h"
+#include "error.h"
+
+#define SHAPEDB_MAGIC "GJKD"
+#define SHAPEDB_BYTE_ORDER 0x01020304u
+
+bool shapedb_load(struct shapedb_t* db, const void* data, size_t size) {
+	memset(db, 0, sizeof(struct shapedb_t));
+
+	struct shapedb_header_t header;
+	if (size < sizeof(header)) {
+		LOG("ERROR: Shape database is too small for its header\n");
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	// The entries and points are read in place, so they need the alignment of their types
+	if ((uintptr_t)data % _Alignof(struct compact_entry_t) != 0) {
+		LOG("ERROR: Shape database isn't aligned to %d bytes\n", (int)_Alignof(struct compact_entry_t));
+		return false;
+	}
+
+	if (memcmp(header.magic, SHAPEDB_MAGIC, 4) != 0 || header.version != SHAPEDB_VERSION) {
+		LOG("ERROR: Not a version %d shape database\n", SHAPEDB_VERSION);
+		return false;
+	}
+	if (header.byte_order != SHAPEDB_BYTE_ORDER || header.scalar_size != sizeof(scalar_t)
+			|| header.entry_size != sizeof(struct compact_entry_t)) {
+		LOG("ERROR: Shape database was built for a different byte order or scalar size\n");
+		return false;
+	}
+	if ((header.width != COMPACT_INT16 && header.width != COMPACT_INT32) || header.file_size > size
+			|| header.entries_offset < sizeof(header) || header.entries_offset > header.file_size
+			|| header.points_offset > header.file_size
+			|| header.entries_offset % SHAPEDB_ALIGNMENT != 0 || header.points_offset % SHAPEDB_ALIGNMENT != 0
+			|| header.entries_offset + (uint64_t)header.num_shapes * header.entry_size > header.points_offset
+			|| header.points_offset + (uint64_t)header.num_points * 2 * header.width > header.file_size) {
+		LOG("ERROR: Shape database is truncated or corrupt\n");
+		return false;
+	}
+
+	const char* bytes = data;
+	db->set = (struct compact_set_t) {
+		.width = header.width,
+		.shapes = (struct compact_entry_t*)(bytes + header.entries_offset),
+		.num_shapes = header.num_shapes,
+		.shapes_capacity = header.num_shapes,
+		.points = (void*)(bytes + header.points_offset),
+		.num_points = header.num_points,
+		.points_capacity = header.num_points,
+		.read_only = true,
+	};
+	db->data = data;
+	db->size = size;
+	return true;
+}
+
+bool shapedb_verify(const struct shapedb_t* db) {
+	const struct compact_set_t* set = &db->set;
+
+	for (int i = 0; i < set->num_shapes; i++) {
+		const struct compact_entry_t* entry = &set->shapes[i];
+		if (entry->num_points == 0 || entry->first > set->num_points || entry->num_points > set->num_points - entry->first) {
+			LOG("ERROR: Points of shape %d are out of range\n", i);
+			return false;
+		}
+
+		for (uint32_t k = entry->first; k < entry->first + entry->num_points; k++) {
+			int32_t x, y;
+			if (set->width == COMPACT_INT16) {
+				const int16_t* points = set->points;
+				x = points[2*k];
+				y = points[2*k+1];
+			} else {
+				const int32_t* points = set->points;
+				x = points[2*k];
+				y = points[2*k+1];
+			}
+
+			if (x < entry->min_x || x > entry->max_x || y < entry->min_y || y > entry->max_y) {
+				LOG("ERROR: Point %d of shape %d is outside its bounds\n", (int)(k - entry->first), i);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void shapedb_close(struct shapedb_t* db) {
+#ifndef TI84PCE
+	if (db->mapped) {
+		munmap((void*)db->data, db->size);
+	}
+#endif
+	memset(db, 0, sizeof(struct shapedb_t));
+}
+
+#ifndef TI84PCE
+
+static uint64_t align_up(uint64_t offset) {
+	return (offset + SHAPEDB_ALIGNMENT - 1) / SHAPEDB_ALIGNMENT * SHAPEDB_ALIGNMENT;
+}
+
+static struct shapedb_header_t make_header(const struct compact_set_t* set) {
+	struct shapedb_header_t header = {
+		.version = SHAPEDB_VERSION,
+		.width = set->width,
+		.byte_order = SHAPEDB_BYTE_ORDER,
+		.scalar_size = sizeof(scalar_t),
+		.entry_size = sizeof(struct compact_entry_t),
+		.num_shapes = set->num_shapes,
+		.num_points = set->num_points,
+	};
+	memcpy(header.magic, SHAPEDB_MAGIC, 4);
+
+	header.entries_offset = align_up(sizeof(struct shapedb_header_t));
+	header.points_offset = align_up(header.entries_offset + (uint64_t)set->num_shapes * sizeof(struct compact_entry_t));
+	header.file_size = header.points_offset + (uint64_t)set->num_points * 2 * set->width;
+	return header;
+}
+
+bool shapedb_write(const struct compact_set_t* set, const char* path) {
+	FILE* f = fopen(path, "wb");
+	if (f == NULL) {
+		LOG("ERROR: Couldn't open %s for writing\n", path);
+		return false;
+	}
+
+	struct shapedb_header_t header = make_header(set);
+	static const char padding[SHAPEDB_ALIGNMENT];
+	size_t entries_size = (size_t)set->num_shapes * sizeof(struct compact_entry_t);
+	size_t points_size = (size_t)set->num_points * 2 * set->width;
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+			&& fwrite(padding, 1, header.entries_offset - sizeof(header), f) == header.entries_offset - sizeof(header)
+			&& fwrite(set->shapes, 1, entries_size, f) == entries_size
+			&& fwrite(padding, 1, header.points_offset - header.entries_offset - entries_size, f) == header.points_offset - header.entries_offset - entries_size
+			&& fwrite(set->points, 1, points_size, f) == points_size;
+
+	if (fclose(f) != 0 || !ok) {
+		LOG("ERROR: Couldn't write %s\n", path);
+		return false;
+	}
+	return true;
+}
+
+bool shapedb_open(struct shapedb_t* db, const char* path) {
+	memset(db, 0, sizeof(struct shapedb_t));
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		LOG("ERROR: Couldn't open %s\n", path);
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		LOG("ERROR: Couldn't read the size of %s\n", path);
+		close(fd);
+		return false;
+	}
+
+	// The mapping stays valid after the file is closed
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		LOG("ERROR: Couldn't map %s\n", path);
+		return false;
+	}
+
+	if (!shapedb_load(db, data, st.st_size)) {
+		munmap(data, st.st_size);
+		return false;
+	}
+	db->mapped = true;
+	return true;
+}
+
+#endif
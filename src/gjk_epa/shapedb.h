@@ -0,0 +1,99 @@
+/**
+ * Precompiled shape databases: a compact set (see compact.h) saved in the layout it has in memory, so loading one is an
+ * mmap and a few pointer assignments. Nothing is parsed or copied, and pages are only read when a query touches them.
+ * Use tools/shapedb.c to build one from polygon definitions.
+ *
+ * File format (native byte order, checked against the loading build):
+ *   header:  "GJKD", u16 version, u16 width, u32 byte order mark 0x01020304,
+ *            u16 sizeof(scalar_t), u16 sizeof(struct compact_entry_t), u32 num_shapes, u32 num_points,
+ *            u64 entries offset, u64 points offset, u64 file size
+ *   entries: num_shapes struct compact_entry_t, at a multiple of SHAPEDB_ALIGNMENT
+ *   points:  num_points (x, y) pairs of width bytes each, at a multiple of SHAPEDB_ALIGNMENT
+ *
+ * Opening only checks the header, since reading every entry would page in the whole file. Databases from somewhere
+ * untrusted should go through shapedb_verify first.
+ */
+
+#ifndef SHAPEDB_H
+#define SHAPEDB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "compact.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHAPEDB_VERSION 1
+
+// Sections start on a cache line
+#define SHAPEDB_ALIGNMENT 64
+
+struct shapedb_header_t {
+	char magic[4];
+	uint16_t version;
+	uint16_t width;
+	uint32_t byte_order;
+	uint16_t scalar_size;
+	uint16_t entry_size;
+	uint32_t num_shapes;
+	uint32_t num_points;
+	uint64_t entries_offset;
+	uint64_t points_offset;
+	uint64_t file_size;
+};
+
+struct shapedb_t {
+	// Shapes of the database, read only. Query it like any other compact set
+	struct compact_set_t set;
+	const void* data;
+	size_t size;
+	bool mapped;
+};
+
+/**
+ * Uses a database that is already in memory, e.g. embedded in the program. data has to stay valid and be aligned to
+ * SHAPEDB_ALIGNMENT, or at least to the alignment of struct compact_entry_t
+ *
+ * @return false if data is misaligned or the header doesn't describe a database this build can read
+ */
+bool shapedb_load(struct shapedb_t* db, const void* data, size_t size);
+
+// The calculator has no files to map
+#ifndef TI84PCE
+
+/**
+ * Writes a compact set to a database file
+ *
+ * @return false if the file couldn't be written
+ */
+bool shapedb_write(const struct compact_set_t* set, const char* path);
+
+/**
+ * Maps a database file into memory read only
+ *
+ * @return false if the file couldn't be mapped or isn't a database this build can read
+ */
+bool shapedb_open(struct shapedb_t* db, const char* path);
+
+#endif
+
+/**
+ * Unmaps the file if it was opened with shapedb_open
+ */
+void shapedb_close(struct shapedb_t* db);
+
+/**
+ * Checks that every shape's points are inside the database and its bounds contain them. Reads the whole file
+ *
+ * @return false at the first shape that's out of range
+ */
+bool shapedb_verify(const struct shapedb_t* db);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <string.h>
+#include "tilemap.h"
+#include "gjk.h"
+#include "collision.h"
+#include "error.h"
+#include "utils.h"
+
+#define INITIAL_STRIPS_CAPACITY 64
+#define NO_STRIP -1
+
+bool tilemap_init(struct tilemap_t* map, int width, int height, scalar_t tile_size, struct vector_t origin) {
+	memset(map, 0, sizeof(struct tilemap_t));
+	map->solid = calloc((size_t)width * height, sizeof(uint8_t));
+	map->strip_of = malloc((size_t)width * height * sizeof(int32_t));
+	if (map->solid == NULL || map->strip_of == NULL) {
+		tilemap_free(map);
+		return false;
+	}
+
+	map->width = width;
+	map->height = height;
+	map->tile_size = tile_size;
+	map->origin = origin;
+	memset(map->strip_of, 0xff, (size_t)width * height * sizeof(int32_t));
+	return true;
+}
+
+void tilemap_free(struct tilemap_t* map) {
+	free(map->solid);
+	free(map->strip_of);
+	free(map->strips);
+	memset(map, 0, sizeof(struct tilemap_t));
+}
+
+void tilemap_set(struct tilemap_t* map, int x, int y, bool solid) {
+	if (x < 0 || y < 0 || x >= map->width || y >= map->height) {
+		return;
+	}
+	map->solid[y * map->width + x] = solid;
+	map->dirty = true;
+}
+
+bool tilemap_get(const struct tilemap_t* map, int x, int y) {
+	if (x < 0 || y < 0 || x >= map->width || y >= map->height) {
+		return false;
+	}
+	return map->solid[y * map->width + x];
+}
+
+// Whether the tile is solid and not part of a strip yet
+static bool free_tile(const struct tilemap_t* map, int x, int y) {
+	int i = y * map->width + x;
+	return map->solid[i] && map->strip_of[i] == NO_STRIP;
+}
+
+static bool add_strip(struct tilemap_t* map, struct tilemap_strip_t strip) {
+	if (map->num_strips == map->strips_capacity) {
+		int capacity = map->strips_capacity == 0 ? INITIAL_STRIPS_CAPACITY : 2 * map->strips_capacity;
+		struct tilemap_strip_t* strips = realloc(map->strips, capacity * sizeof(struct tilemap_strip_t));
+		if (strips == NULL) {
+			return false;
+		}
+		map->strips = strips;
+		map->strips_capacity = capacity;
+	}
+
+	for (int y = strip.y; y < strip.y + strip.height; y++) {
+		for (int x = strip.x; x < strip.x + strip.width; x++) {
+			map->strip_of[y * map->width + x] = map->num_strips;
+		}
+	}
+	map->strips[map->num_strips++] = strip;
+	return true;
+}
+
+bool tilemap_build(struct tilemap_t* map) {
+	memset(map->strip_of, 0xff, (size_t)map->width * map->height * sizeof(int32_t));
+	map->num_strips = 0;
+
+	for (int y = 0; y < map->height; y++) {
+		for (int x = 0; x < map->width; x++) {
+			if (!free_tile(map, x, y)) {
+				continue;
+			}
+
+			struct tilemap_strip_t strip = {x, y, 1, 1};
+			while (strip.x + strip.width < map->width && free_tile(map, strip.x + strip.width, y)) {
+				strip.width++;
+			}
+
+			for (bool full = true; full && strip.y + strip.height < map->height; ) {
+				for (int k = strip.x; k < strip.x + strip.width && full; k++) {
+					full = free_tile(map, k, strip.y + strip.height);
+				}
+				strip.height += full;
+			}
+
+			if (!add_strip(map, strip)) {
+				LOG("ERROR: Out of memory for the strips of the tile map\n");
+				return false;
+			}
+			x += strip.width - 1;
+		}
+	}
+
+	map->dirty = false;
+	return true;
+}
+
+struct aabb_t tilemap_strip_bounds(const struct tilemap_t* map, int strip) {
+	const struct tilemap_strip_t* s = &map->strips[strip];
+	return (struct aabb_t) {
+		{map->origin.x + s->x * map->tile_size, map->origin.y + s->y * map->tile_size},
+		{map->origin.x + (s->x + s->width) * map->tile_size, map->origin.y + (s->y + s->height) * map->tile_size},
+	};
+}
+
+static int clamp(scalar_t v, int max) {
+	return v < 0 ? 0 : v > max ? max : (int)v;
+}
+
+static bool collide_strip(struct polygon_t poly, struct vector_t centroid, struct aabb_t bounds, struct vector_t* penetration) {
+	struct vector_t points[4] = {
+		bounds.min,
+		{bounds.min.x, bounds.max.y},
+		bounds.max,
+		{bounds.max.x, bounds.min.y},
+	};
+	struct polygon_t box = {points, 4};
+	struct vector_t center = {bounds.min.x + (bounds.max.x - bounds.min.x) / 2, bounds.min.y + (bounds.max.y - bounds.min.y) / 2};
+	struct vector_t d = sub(center, centroid);
+
+	if (penetration == NULL) {
+		return gjk_collision_generic(polygon_farthest_point, &poly, polygon_farthest_point, &box, d, NULL, NULL, NULL, NULL);
+	}
+
+	struct collision_t collision;
+	bool colliding = collide_direction(poly, box, d, &collision);
+	*penetration = collision_penetration(&collision);
+	return colliding;
+}
+
+int tilemap_collision(const struct tilemap_t* map, struct polygon_t poly, int max_hits, bool penetrations, struct tilemap_hit_t* hits) {
+	if (map->dirty) {
+		LOG("ERROR: Tile map changed since tilemap_build\n");
+		return -1;
+	}
+
+	// Tiles touching the bounds, min and max included. Tile x covers [x, x + 1] * tile_size
+	struct aabb_t bounds = get_aabb(poly);
+	scalar_t min_x = floor_div(bounds.min.x - map->origin.x - 1, map->tile_size);
+	scalar_t min_y = floor_div(bounds.min.y - map->origin.y - 1, map->tile_size);
+	scalar_t max_x = floor_div(bounds.max.x - map->origin.x, map->tile_size);
+	scalar_t max_y = floor_div(bounds.max.y - map->origin.y, map->tile_size);
+	if (max_x < 0 || max_y < 0 || min_x >= map->width || min_y >= map->height) {
+		return 0;
+	}
+	int x0 = clamp(min_x, map->width - 1);
+	int y0 = clamp(min_y, map->height - 1);
+	int x1 = clamp(max_x, map->width - 1);
+	int y1 = clamp(max_y, map->height - 1);
+
+	struct vector_t centroid = get_centroid(poly);
+	int num_hits = 0;
+
+	for (int y = y0; y <= y1 && num_hits < max_hits; y++) {
+		for (int x = x0; x <= x1 && num_hits < max_hits; x++) {
+			int id = map->strip_of[y * map->width + x];
+			if (id == NO_STRIP) {
+				continue;
+			}
+
+			// A strip is tested at its first tile under the bounds, and the rest of its row is skipped
+			const struct tilemap_strip_t* s = &map->strips[id];
+			bool first = x == (s->x > x0 ? s->x : x0) && y == (s->y > y0 ? s->y : y0);
+			x = s->x + s->width - 1;
+			if (!first) {
+				continue;
+			}
+
+			struct vector_t penetration = {0, 0};
+			if (collide_strip(poly, centroid, tilemap_strip_bounds(map, id), penetrations ? &penetration : NULL)) {
+				hits[num_hits++] = (struct tilemap_hit_t){id, penetration};
+			}
+		}
+	}
+
+	return num_hits;
+}
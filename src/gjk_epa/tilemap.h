@@ -0,0 +1,100 @@
+/**
+ * Grid of square solid or empty tiles, tested against polygons without a polygon per tile
+ *
+ * tilemap_build merges neighbouring solid tiles into rectangular strips: runs of tiles along a row, extended down over
+ * the rows below while they're solid under the whole run. A query only looks at the tiles under the polygon's bounds and
+ * runs GJK (and EPA) once per strip found there, so its cost depends on the polygon's size and not on the map's.
+ * Since a flat floor or wall is one strip, polygons sliding along it aren't caught on the edges between its tiles.
+ */
+
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Rectangle of solid tiles, in tiles
+ */
+struct tilemap_strip_t {
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+struct tilemap_t {
+	int width;
+	int height;
+	scalar_t tile_size;
+	// World position of the corner of tile (0, 0). Tile (x, y) covers origin + (x, y) * tile_size to origin + (x + 1, y + 1) * tile_size
+	struct vector_t origin;
+	uint8_t* solid;
+
+	// Strip of every tile, -1 for empty tiles
+	int32_t* strip_of;
+	struct tilemap_strip_t* strips;
+	int num_strips;
+	int strips_capacity;
+	// Tiles changed since the last tilemap_build
+	bool dirty;
+};
+
+struct tilemap_hit_t {
+	int strip;
+	// Like collision_penetration(poly, strip), or (0, 0) if penetrations weren't asked for
+	struct vector_t penetration;
+};
+
+/**
+ * Starts with every tile empty
+ *
+ * @return false if out of memory
+ */
+bool tilemap_init(struct tilemap_t* map, int width, int height, scalar_t tile_size, struct vector_t origin);
+
+void tilemap_free(struct tilemap_t* map);
+
+/**
+ * Tiles outside the map are ignored. Call tilemap_build after the last change before querying again
+ */
+void tilemap_set(struct tilemap_t* map, int x, int y, bool solid);
+
+/**
+ * @return false for empty tiles and tiles outside the map
+ */
+bool tilemap_get(const struct tilemap_t* map, int x, int y);
+
+/**
+ * Merges the solid tiles into strips again. Walks the whole map, so do it after loading or editing, not every frame
+ *
+ * @return false if out of memory
+ */
+bool tilemap_build(struct tilemap_t* map);
+
+/**
+ * @return bounds of a strip in world coordinates
+ */
+struct aabb_t tilemap_strip_bounds(const struct tilemap_t* map, int strip);
+
+/**
+ * Finds the strips that collide with poly, in the order of their first tile under poly's bounds, row by row.
+ * Touching counts as a collision, like gjk_collision
+ *
+ * @param max_hits stops after this many hits, QUERY_ALL_HITS (see query.h) to check every strip
+ * @param penetrations whether to run EPA on the hits
+ * @param hits room for max_hits hits, or for as many strips as there can be under poly's bounds
+ * @return number of hits written, or -1 if the map changed since the last tilemap_build
+ */
+int tilemap_collision(const struct tilemap_t* map, struct polygon_t poly, int max_hits, bool penetrations, struct tilemap_hit_t* hits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,3 +18,11 @@ void convert_to_sdl_arr(int* points, int num_points, int16_t* x_arr, int16_t* y_
 		y_arr[i] = points[2*i+1];
 	}
 }
+
+/**
+ * Divides rounding towards negative infinity, unlike /
+ */
+scalar_t floor_div(scalar_t a, scalar_t b) {
+	scalar_t q = a / b;
+	return a % b < 0 ? q - 1 : q;
+}
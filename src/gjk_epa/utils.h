@@ -12,4 +12,11 @@ void convert_to_polygon_t(int *points, int num_points, struct polygon_t* polygon
  * Convert int* points into x_arr and y_arr used by the sdl2 gfx functions
  */
 void convert_to_sdl_arr(int* points, int num_points, int16_t* x_arr, int16_t* y_arr);
+
+/**
+ * Divides rounding towards negative infinity, unlike /, e.g. to find the grid cell of a coordinate
+ *
+ * @param b has to be positive
+ */
+scalar_t floor_div(scalar_t a, scalar_t b);
 #endif
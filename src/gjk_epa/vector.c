@@ -4,50 +4,100 @@
  * I treat points as euclidean vectors since they're basically the same
  */
 
+#if defined(__wasm_simd128__) && !defined(GJK_NARROW_SCALAR)
+#include <wasm_simd128.h>
+#endif
 #include "vector.h"
 #include "fixed_point.h"
 
-int64_t dot(struct vector_t v1, struct vector_t v2) {
-	return v1.x*v2.x + v1.y*v2.y;
-}
+extern inline scalar_t dot(struct vector_t v1, struct vector_t v2);
+extern inline struct vector_t sub(struct vector_t v1, struct vector_t v2);
+extern inline struct vector_t scalar_mult(scalar_t s, struct vector_t v);
 
-struct vector_t sub(struct vector_t v1, struct vector_t v2) {
-	return (struct vector_t) {
-		.x = v1.x-v2.x,
-		.y = v1.y-v2.y,
-	};
+#ifdef GJK_NARROW_SCALAR
+// Components are kept below this before they're multiplied with each other, so products stay below 2^29
+#define NARROW_COMPONENT_LIMIT ((scalar_t)1 << 14)
+
+/*
+ * Halves v until both components are below NARROW_COMPONENT_LIMIT.
+ * The direction only changes by rounding
+ */
+static struct vector_t reduce(struct vector_t v) {
+	while (v.x >= NARROW_COMPONENT_LIMIT || v.x <= -NARROW_COMPONENT_LIMIT
+			|| v.y >= NARROW_COMPONENT_LIMIT || v.y <= -NARROW_COMPONENT_LIMIT) {
+		v.x /= 2;
+		v.y /= 2;
+	}
+	return v;
 }
 
-struct vector_t scalar_mult(int64_t s, struct vector_t v) {
-	return (struct vector_t) {
-		.x= s * v.x,
-		.y= s * v.y,
-	};
+scalar_t cross(struct vector_t v1, struct vector_t v2) {
+	v1 = reduce(v1);
+	v2 = reduce(v2);
+	return v1.x*v2.y - v1.y*v2.x;
 }
 
-// Note: Values sometimes overflow
+/*
+ * In 2D, (v1 x v2) x v3 = (v1 x v2) * (-v3.y, v3.x), so it's v3 rotated by 90 degrees and scaled by the cross product.
+ * Callers only use the direction, so skip the scaling which would need 64 bits
+ */
 struct vector_t triple_product2(struct vector_t v1, struct vector_t v2, struct vector_t v3) {
-	int64_t v1_v3_dp = dot(v1, v3);
-	int64_t v3_v2_dp = dot(v3, v2);
-	struct vector_t t1 = scalar_mult(v1_v3_dp, v2);
-	struct vector_t t2 = scalar_mult(v3_v2_dp, v1);
-	return sub(t1, t2);
+	scalar_t c = cross(v1, v2);
+	if (c == 0) {
+		return (struct vector_t){0, 0};
+	}
+	return c > 0 ? (struct vector_t){-v3.y, v3.x} : (struct vector_t){v3.y, -v3.x};
 }
+#else
+extern inline scalar_t cross(struct vector_t v1, struct vector_t v2);
+extern inline struct vector_t triple_product2(struct vector_t v1, struct vector_t v2, struct vector_t v3);
+#endif
 
 /**
  * https://en.wikipedia.org/wiki/Integer_square_root#Example_implementation_in_C
  */
-int64_t int_sqrt(int64_t s) {
+#ifdef GJK_NARROW_SCALAR
+/*
+ * Digit by digit version, since the eZ80 has no divide instruction
+ * https://en.wikipedia.org/wiki/Integer_square_root#Digit-by-digit_algorithm
+ */
+scalar_t int_sqrt(scalar_t s) {
+	if (s <= 1)
+		return s;
+
+	scalar_t result = 0;
+	scalar_t bit = (scalar_t)1 << 30;
+	while (bit > s) {
+		bit >>= 2;
+	}
+
+	while (bit != 0) {
+		if (s >= result + bit) {
+			s -= result + bit;
+			result = (result >> 1) + bit;
+		} else {
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+	return result;
+}
+#else
+scalar_t int_sqrt(scalar_t s) {
 	// Zero yields zero
     // One yields one
 	if (s <= 1) 
 		return s;
 
-    // Initial estimate (must be too high)
-	int64_t x0 = s / 2;
+    // Initial estimate (must be too high). A power of two at or above the root saves most of the
+	// iterations s / 2 would need, and gives the same result
+	scalar_t x0 = 1;
+	for (scalar_t t = s; t > 0; t >>= 2) {
+		x0 <<= 1;
+	}
 
 	// Update
-	int64_t x1 = (x0 + s / x0) / 2;
+	scalar_t x1 = (x0 + s / x0) / 2;
 
 	while (x1 < x0)	// Bound check
 	{
@@ -56,6 +106,7 @@ int64_t int_sqrt(int64_t s) {
 	}		
 	return x0;
 }
+#endif
 
 /*
  * Won't be exact since int is used instead of floats
@@ -64,13 +115,17 @@ int64_t int_sqrt(int64_t s) {
  *
  */
 struct vector_t normalize(struct vector_t v) {
-	int64_t dp = dot(v, v);
+#ifdef GJK_NARROW_SCALAR
+	// Fixed point edges are too long to square in 32 bits, and only the direction matters here
+	v = reduce(v);
+#endif
+	scalar_t dp = dot(v, v);
 
 	if (dp == 0) {
 		return v;
 	}
 
-	int64_t norm = int_sqrt(dp);
+	scalar_t norm = int_sqrt(dp);
 	
 	// Anytime division is done, convert to fixed point again since division cancels out the scaling factor
 	v.x = int_to_fixed_point(v.x);
@@ -86,15 +141,43 @@ struct vector_t normalize(struct vector_t v) {
  * Won't be exact, but we don't need precision
  */
 struct vector_t get_centroid(struct polygon_t poly) {
-	int64_t sum_x = 0, sum_y = 0;
+	scalar_t sum_x = 0, sum_y = 0;
 
+#if defined(__wasm_simd128__) && !defined(GJK_NARROW_SCALAR)
+	// x and y are adjacent in memory, so both sums fit in one register
+	v128_t sum = wasm_i64x2_splat(0);
+	for (int i = 0; i < poly.num_points; i++) {
+		sum = wasm_i64x2_add(sum, wasm_v128_load(&poly.points[i]));
+	}
+	sum_x = wasm_i64x2_extract_lane(sum, 0);
+	sum_y = wasm_i64x2_extract_lane(sum, 1);
+#else
 	for (int i = 0; i < poly.num_points; i++) {
 		sum_x += poly.points[i].x;
 		sum_y += poly.points[i].y;
 	}
+#endif
 
 	return (struct vector_t) {
 		.x= sum_x/poly.num_points,
 		.y= sum_y/poly.num_points,
 	};
 }
+
+struct aabb_t get_aabb(struct polygon_t poly) {
+	struct aabb_t box = {poly.points[0], poly.points[0]};
+
+	for (int i = 1; i < poly.num_points; i++) {
+		struct vector_t p = poly.points[i];
+		if (p.x < box.min.x) box.min.x = p.x;
+		if (p.y < box.min.y) box.min.y = p.y;
+		if (p.x > box.max.x) box.max.x = p.x;
+		if (p.y > box.max.y) box.max.y = p.y;
+	}
+
+	return box;
+}
+
+bool aabb_overlap(struct aabb_t a, struct aabb_t b) {
+	return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y;
+}
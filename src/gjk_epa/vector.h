@@ -7,15 +7,29 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// The eZ80 in the TI-84+ CE has 24-bit registers, so every 64-bit operation becomes a slow library call.
+// Narrow builds use 32-bit scalars and keep intermediate results in range (see cross, triple_product2 and normalize),
+// which is enough for coordinates up to about +-8000
+#if defined(TI84PCE) && !defined(GJK_WIDE_SCALAR)
+#define GJK_NARROW_SCALAR
+#endif
+
+#ifdef GJK_NARROW_SCALAR
+typedef int32_t scalar_t;
+#else
+typedef int64_t scalar_t;
+#endif
+
 struct vector_t {
-	int64_t x;
-	int64_t y;
+	scalar_t x;
+	scalar_t y;
 };
 
 struct polygon_t {
@@ -23,35 +37,83 @@ struct polygon_t {
 	int num_points;
 };
 
+/**
+ * Axis aligned bounding box, min and max included
+ */
+struct aabb_t {
+	struct vector_t min;
+	struct vector_t max;
+};
+
 struct edge_t {
-	int64_t distance;
+	scalar_t distance;
 	struct vector_t normal;
 	int index;
 };
 
+// The small operations are defined here so GJK and EPA inline them without link time optimization. vector.c has
+// the out of line copies for callers that take their address. From C++14 they're also usable in constant expressions
+#if defined(__cplusplus) && __cplusplus >= 201402L
+#define VECTOR_INLINE constexpr inline
+#else
+#define VECTOR_INLINE inline
+#endif
+
 /**
  * Computes \f$(\pmb{v_1} \dot \pmb{v_2})\f$
  */
-int64_t dot(struct vector_t v1, struct vector_t v2);
+VECTOR_INLINE scalar_t dot(struct vector_t v1, struct vector_t v2) {
+	return v1.x*v2.x + v1.y*v2.y;
+}
 
 /**
  * Computes \f$(\pmb{v_1} - \pmb{v_2})\f$
  */
-struct vector_t sub(struct vector_t v1, struct vector_t v2);
-
+VECTOR_INLINE struct vector_t sub(struct vector_t v1, struct vector_t v2) {
+	struct vector_t v = {v1.x-v2.x, v1.y-v2.y};
+	return v;
+}
 
 /**
  * Computes \f$(s  \pmb{v})\f$ with scalar, s, and vector, v
  */
-struct vector_t scalar_mult(int64_t s, struct vector_t v);
+VECTOR_INLINE struct vector_t scalar_mult(scalar_t s, struct vector_t v) {
+	struct vector_t r = {s * v.x, s * v.y};
+	return r;
+}
+
+#ifdef GJK_NARROW_SCALAR
+/**
+ * Computes the z component of \f$(\pmb{v_1} \times \pmb{v_2})\f$
+ *
+ * Large inputs are scaled down first, so only the sign is meaningful
+ */
+scalar_t cross(struct vector_t v1, struct vector_t v2);
+
+/**
+ * Computes the direction of (v1 x v2 x v3): v3 rotated by 90 degrees towards the side given by sign(v1 x v2).
+ * The full product needs 64 bits
+ */
+struct vector_t triple_product2(struct vector_t v1, struct vector_t v2, struct vector_t v3);
+#else
+/**
+ * Computes the z component of \f$(\pmb{v_1} \times \pmb{v_2})\f$
+ */
+VECTOR_INLINE scalar_t cross(struct vector_t v1, struct vector_t v2) {
+	return v1.x*v2.y - v1.y*v2.x;
+}
 
 /**
  * Computes (v1 x v2 x v3) using the following identity:
  *
  * \f$ (\pmb{v_1} x \pmb{v_2}) x \pmb{v_3} = (\pmb{v_1} \dot \pmb{v_3}) \pmb{v_2} - (\pmb{v_3} \dot \pmb{v_2}) \pmb{v_1} \f$
  *
+ * Note: Values sometimes overflow
  */
-struct vector_t triple_product2(struct vector_t v1, struct vector_t v2, struct vector_t v3);
+VECTOR_INLINE struct vector_t triple_product2(struct vector_t v1, struct vector_t v2, struct vector_t v3) {
+	return sub(scalar_mult(dot(v1, v3), v2), scalar_mult(dot(v3, v2), v1));
+}
+#endif
 
 /**
  * Returns the integer square root of a number
@@ -59,7 +121,7 @@ struct vector_t triple_product2(struct vector_t v1, struct vector_t v2, struct v
  *
  * Copied from https://en.wikipedia.org/wiki/Integer_square_root#Example_implementation_in_C
  */
-int64_t int_sqrt(int64_t s);
+scalar_t int_sqrt(scalar_t s);
 
 /**
  * Normalizes vector only if dot(v, v) != 0
@@ -76,6 +138,16 @@ struct vector_t normalize(struct vector_t v);
  */
 struct vector_t get_centroid(struct polygon_t poly);
 
+/**
+ * Computes the smallest axis aligned box around a polygon
+ */
+struct aabb_t get_aabb(struct polygon_t poly);
+
+/**
+ * @return true if the boxes overlap or touch
+ */
+bool aabb_overlap(struct aabb_t a, struct aabb_t b);
+
 #ifdef __cplusplus
 }
 #endif
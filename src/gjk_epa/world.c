@@ -0,0 +1,450 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world.h"
+#include "collision.h"
+#include "error.h"
+#include "utils.h"
+
+#define INITIAL_SHAPES_CAPACITY 64
+#define INITIAL_PAIRS_CAPACITY 256
+#define INITIAL_CELL_BUCKETS 128
+#define INITIAL_CELL_ENTRIES_CAPACITY 256
+#define NO_CELL_ENTRY -1
+// Range of cell coordinates, small enough that the number of cells a shape covers fits in an int
+#define MAX_CELL (INT_MAX / 2)
+
+// Pairs start out empty and are never removed one by one. An entry whose versions are behind its shapes is stale:
+// one of them moved and the bounds stopped overlapping, or the pair was skipped because a shape is asleep.
+// Stale entries are dropped whenever the table grows.
+#define EMPTY_PAIR -1
+
+void world_init(struct world_t* world, int flags) {
+	memset(world, 0, sizeof(struct world_t));
+	world->flags = flags;
+	world->cell_size = WORLD_DEFAULT_CELL_SIZE;
+	world->free_cell_entry = NO_CELL_ENTRY;
+}
+
+void world_free(struct world_t* world) {
+	free(world->shapes);
+	free(world->dirty);
+	free(world->pairs);
+	free(world->cell_buckets);
+	free(world->cell_entries);
+	free(world->big);
+	memset(world, 0, sizeof(struct world_t));
+}
+
+static uint32_t pair_hash(int a, int b) {
+	return ((uint32_t)a * 0x9E3779B1u) ^ ((uint32_t)b * 0x85EBCA77u);
+}
+
+static bool pair_stale(const struct world_t* world, const struct world_pair_t* pair) {
+	return pair->version_a != world->shapes[pair->a].version || pair->version_b != world->shapes[pair->b].version;
+}
+
+static struct world_pair_t* find_pair(const struct world_t* world, int a, int b) {
+	if (world->pairs_capacity == 0) {
+		return NULL;
+	}
+
+	int mask = world->pairs_capacity - 1;
+	for (int i = pair_hash(a, b) & mask; ; i = (i + 1) & mask) {
+		struct world_pair_t* pair = &world->pairs[i];
+		if (pair->a == EMPTY_PAIR || (pair->a == a && pair->b == b)) {
+			return pair;
+		}
+	}
+}
+
+// Keeps the table at most half full, dropping the stale entries on the way
+static bool grow_pairs(struct world_t* world) {
+	int live = 0;
+	for (int i = 0; i < world->pairs_capacity; i++) {
+		live += world->pairs[i].a != EMPTY_PAIR && !pair_stale(world, &world->pairs[i]);
+	}
+
+	int capacity = world->pairs_capacity == 0 ? INITIAL_PAIRS_CAPACITY : world->pairs_capacity;
+	while (2 * (live + 1) > capacity) {
+		capacity *= 2;
+	}
+
+	struct world_pair_t* pairs = malloc(capacity * sizeof(struct world_pair_t));
+	if (pairs == NULL) {
+		LOG("ERROR: Couldn't grow the pair cache to %d pairs\n", capacity);
+		return false;
+	}
+
+	struct world_pair_t* old = world->pairs;
+	int old_capacity = world->pairs_capacity;
+
+	for (int i = 0; i < capacity; i++) {
+		pairs[i].a = EMPTY_PAIR;
+	}
+	world->pairs = pairs;
+	world->pairs_capacity = capacity;
+	world->num_pairs = 0;
+
+	for (int i = 0; i < old_capacity; i++) {
+		if (old[i].a != EMPTY_PAIR && !pair_stale(world, &old[i])) {
+			*find_pair(world, old[i].a, old[i].b) = old[i];
+			world->num_pairs++;
+		}
+	}
+
+	free(old);
+	return true;
+}
+
+static void update_pair(struct world_t* world, int a, int b) {
+	struct world_shape_t* shape_a = &world->shapes[a];
+	struct world_shape_t* shape_b = &world->shapes[b];
+
+	world->stats.pairs_checked++;
+
+	struct world_pair_t* pair = find_pair(world, a, b);
+	if (pair != NULL && pair->a != EMPTY_PAIR && !pair_stale(world, pair)) {
+		return;
+	}
+
+	world->stats.pairs_computed++;
+
+	struct world_pair_t scratch;
+	if (pair == NULL || pair->a == EMPTY_PAIR) {
+		if (2 * (world->num_pairs + 1) > world->pairs_capacity && !grow_pairs(world)) {
+			// Out of memory, so the result is computed but not kept
+			pair = &scratch;
+		} else {
+			pair = find_pair(world, a, b);
+			world->num_pairs++;
+		}
+		pair->a = a;
+		pair->b = b;
+		epa_cache_reset(&pair->epa_cache);
+	}
+
+	struct collision_t collision;
+	pair->colliding = collide(shape_a->poly, shape_b->poly, &collision);
+	pair->penetration = collision_penetration_cached(&collision, &pair->epa_cache);
+	pair->version_a = shape_a->version;
+	pair->version_b = shape_b->version;
+}
+
+int world_add_shape(struct world_t* world, struct polygon_t poly) {
+	if (world->num_shapes == world->shapes_capacity) {
+		int capacity = world->shapes_capacity == 0 ? INITIAL_SHAPES_CAPACITY : 2 * world->shapes_capacity;
+
+		struct world_shape_t* shapes = realloc(world->shapes, capacity * sizeof(struct world_shape_t));
+		if (shapes == NULL) {
+			return -1;
+		}
+		world->shapes = shapes;
+
+		int* dirty = realloc(world->dirty, capacity * sizeof(int));
+		if (dirty == NULL) {
+			return -1;
+		}
+		world->dirty = dirty;
+
+		int* big = realloc(world->big, capacity * sizeof(int));
+		if (big == NULL) {
+			return -1;
+		}
+		world->big = big;
+		world->shapes_capacity = capacity;
+	}
+
+	int id = world->num_shapes++;
+	world->shapes[id] = (struct world_shape_t) {
+		.poly = poly,
+		.version = 0,
+		.sleeping = false,
+		.dirty = false,
+		.cells = {0, 0, -1, -1},
+		.big = false,
+		.visit = 0,
+	};
+	world_shape_moved(world, id);
+
+	return id;
+}
+
+void world_shape_moved(struct world_t* world, int id) {
+	struct world_shape_t* shape = &world->shapes[id];
+
+	shape->version++;
+	shape->bounds = get_aabb(shape->poly);
+
+	if (!shape->dirty) {
+		shape->dirty = true;
+		world->dirty[world->num_dirty++] = id;
+	}
+}
+
+void world_set_sleeping(struct world_t* world, int id, bool sleeping) {
+	struct world_shape_t* shape = &world->shapes[id];
+
+	if (shape->sleeping && !sleeping) {
+		world_shape_moved(world, id);
+	}
+	shape->sleeping = sleeping;
+}
+
+static bool skipped(const struct world_t* world, const struct world_shape_t* shape) {
+	return (world->flags & WORLD_SKIP_SLEEPING) && shape->sleeping;
+}
+
+// Cell of a coordinate. Cells past the grid's range are clamped to its edge, and share it with their neighbours
+static int cell_of(const struct world_t* world, scalar_t coordinate) {
+	scalar_t cell = floor_div(coordinate, world->cell_size);
+	return cell < -MAX_CELL ? -MAX_CELL : cell > MAX_CELL ? MAX_CELL : (int)cell;
+}
+
+static struct world_cells_t cells_of(const struct world_t* world, struct aabb_t bounds) {
+	return (struct world_cells_t) {
+		cell_of(world, bounds.min.x),
+		cell_of(world, bounds.min.y),
+		cell_of(world, bounds.max.x),
+		cell_of(world, bounds.max.y),
+	};
+}
+
+static int64_t num_cells(struct world_cells_t cells) {
+	if (cells.max_x < cells.min_x) {
+		return 0;
+	}
+	return (int64_t)(cells.max_x - cells.min_x + 1) * (cells.max_y - cells.min_y + 1);
+}
+
+static bool same_cells(struct world_cells_t a, struct world_cells_t b) {
+	return a.min_x == b.min_x && a.min_y == b.min_y && a.max_x == b.max_x && a.max_y == b.max_y;
+}
+
+static int* cell_bucket(const struct world_t* world, int x, int y) {
+	return &world->cell_buckets[pair_hash(x, y) & (world->num_cell_buckets - 1)];
+}
+
+// Makes room for n more entries, so listing a shape can't fail halfway
+static bool reserve_cell_entries(struct world_t* world, int64_t n) {
+	int64_t needed = world->num_cell_entries + n;
+	if (needed <= world->cell_entries_capacity) {
+		return true;
+	}
+
+	int64_t capacity = world->cell_entries_capacity == 0 ? INITIAL_CELL_ENTRIES_CAPACITY : world->cell_entries_capacity;
+	while (capacity < needed) {
+		capacity *= 2;
+	}
+	struct world_cell_entry_t* entries = realloc(world->cell_entries, capacity * sizeof(struct world_cell_entry_t));
+	if (entries == NULL) {
+		return false;
+	}
+	world->cell_entries = entries;
+	world->cell_entries_capacity = capacity;
+	return true;
+}
+
+static void add_cell_entry(struct world_t* world, int* bucket, int shape) {
+	int e = world->free_cell_entry;
+	if (e != NO_CELL_ENTRY) {
+		world->free_cell_entry = world->cell_entries[e].next;
+	} else {
+		e = world->num_cell_entries++;
+	}
+	world->cell_entries[e] = (struct world_cell_entry_t){shape, *bucket};
+	*bucket = e;
+}
+
+static void remove_cell_entry(struct world_t* world, int* bucket, int shape) {
+	for (int* link = bucket; *link != NO_CELL_ENTRY; link = &world->cell_entries[*link].next) {
+		int e = *link;
+		if (world->cell_entries[e].shape == shape) {
+			*link = world->cell_entries[e].next;
+			world->cell_entries[e].next = world->free_cell_entry;
+			world->free_cell_entry = e;
+			return;
+		}
+	}
+}
+
+static void unlist_shape(struct world_t* world, int id) {
+	struct world_shape_t* shape = &world->shapes[id];
+
+	if (shape->big) {
+		for (int k = 0; k < world->num_big; k++) {
+			if (world->big[k] == id) {
+				world->big[k] = world->big[--world->num_big];
+				break;
+			}
+		}
+		shape->big = false;
+	} else {
+		struct world_cells_t c = shape->cells;
+		for (int y = c.min_y; y <= c.max_y && c.min_x <= c.max_x; y++) {
+			for (int x = c.min_x; x <= c.max_x; x++) {
+				remove_cell_entry(world, cell_bucket(world, x, y), id);
+			}
+		}
+	}
+	shape->cells = (struct world_cells_t){0, 0, -1, -1};
+}
+
+static void list_shape(struct world_t* world, int id, struct world_cells_t cells) {
+	struct world_shape_t* shape = &world->shapes[id];
+	int64_t n = num_cells(cells);
+
+	// Shapes the grid has no room for are treated like big ones, which is slower but gives the same pairs
+	if (n > WORLD_MAX_SHAPE_CELLS || world->num_cell_buckets == 0 || !reserve_cell_entries(world, n)) {
+		shape->big = true;
+		world->big[world->num_big++] = id;
+		return;
+	}
+
+	for (int y = cells.min_y; y <= cells.max_y; y++) {
+		for (int x = cells.min_x; x <= cells.max_x; x++) {
+			add_cell_entry(world, cell_bucket(world, x, y), id);
+		}
+	}
+	shape->cells = cells;
+}
+
+// Keeps at least twice as many buckets as shapes, listing every shape again when they grow
+static void grow_cell_buckets(struct world_t* world) {
+	int num_buckets = world->num_cell_buckets == 0 ? INITIAL_CELL_BUCKETS : world->num_cell_buckets;
+	while (num_buckets < 2 * world->num_shapes) {
+		num_buckets *= 2;
+	}
+	int* buckets = malloc(num_buckets * sizeof(int));
+	if (buckets == NULL) {
+		LOG("ERROR: Couldn't grow the grid to %d buckets\n", num_buckets);
+		return;
+	}
+
+	free(world->cell_buckets);
+	world->cell_buckets = buckets;
+	world->num_cell_buckets = num_buckets;
+	for (int i = 0; i < num_buckets; i++) {
+		buckets[i] = NO_CELL_ENTRY;
+	}
+	world->num_cell_entries = 0;
+	world->free_cell_entry = NO_CELL_ENTRY;
+
+	for (int id = 0; id < world->num_shapes; id++) {
+		struct world_shape_t* shape = &world->shapes[id];
+		if (!shape->big && num_cells(shape->cells) > 0) {
+			list_shape(world, id, shape->cells);
+		}
+	}
+}
+
+// Starts a new search for pairs, so every shape counts as not visited yet
+static uint32_t next_visit(struct world_t* world) {
+	if (++world->visit == 0) {
+		for (int id = 0; id < world->num_shapes; id++) {
+			world->shapes[id].visit = 0;
+		}
+		world->visit = 1;
+	}
+	return world->visit;
+}
+
+static void check_pair(struct world_t* world, int a, int b, uint32_t visit) {
+	struct world_shape_t* other = &world->shapes[b];
+	if (other->visit == visit) {
+		return;
+	}
+	other->visit = visit;
+
+	if (skipped(world, other) || !aabb_overlap(world->shapes[a].bounds, other->bounds)) {
+		return;
+	}
+	if (a < b) {
+		update_pair(world, a, b);
+	} else {
+		update_pair(world, b, a);
+	}
+}
+
+void world_step(struct world_t* world) {
+	world->stats = (struct world_stats_t){0, 0};
+
+	for (int k = 0; k < world->num_dirty; k++) {
+		world->shapes[world->dirty[k]].dirty = false;
+	}
+
+	if (world->num_cell_buckets < 2 * world->num_shapes) {
+		grow_cell_buckets(world);
+	}
+
+	// Every moved shape is in its new cells before any of them looks for pairs, so pairs of two moved shapes are found
+	for (int k = 0; k < world->num_dirty; k++) {
+		int id = world->dirty[k];
+		struct world_shape_t* shape = &world->shapes[id];
+		struct world_cells_t cells = cells_of(world, shape->bounds);
+		if (shape->big || !same_cells(cells, shape->cells)) {
+			unlist_shape(world, id);
+			list_shape(world, id, cells);
+		}
+	}
+
+	for (int k = 0; k < world->num_dirty; k++) {
+		int a = world->dirty[k];
+		struct world_shape_t* shape = &world->shapes[a];
+		if (skipped(world, shape)) {
+			continue;
+		}
+
+		uint32_t visit = next_visit(world);
+		shape->visit = visit;
+
+		if (shape->big) {
+			for (int b = 0; b < world->num_shapes; b++) {
+				check_pair(world, a, b, visit);
+			}
+			continue;
+		}
+
+		struct world_cells_t c = shape->cells;
+		for (int y = c.min_y; y <= c.max_y; y++) {
+			for (int x = c.min_x; x <= c.max_x; x++) {
+				for (int e = *cell_bucket(world, x, y); e != NO_CELL_ENTRY; e = world->cell_entries[e].next) {
+					check_pair(world, a, world->cell_entries[e].shape, visit);
+				}
+			}
+		}
+		for (int i = 0; i < world->num_big; i++) {
+			check_pair(world, a, world->big[i], visit);
+		}
+	}
+
+	world->num_dirty = 0;
+}
+
+bool world_pair_colliding(const struct world_t* world, int a, int b, struct vector_t* penetration) {
+	bool swapped = a > b;
+	struct world_pair_t* pair = swapped ? find_pair(world, b, a) : find_pair(world, a, b);
+
+	bool colliding = pair != NULL && pair->a != EMPTY_PAIR && !pair_stale(world, pair) && pair->colliding;
+
+	if (penetration != NULL) {
+		*penetration = colliding ? pair->penetration : (struct vector_t){0, 0};
+		if (swapped) {
+			*penetration = scalar_mult(-1, *penetration);
+		}
+	}
+
+	return colliding;
+}
+
+const struct world_pair_t* world_next_contact(const struct world_t* world, int* cursor) {
+	for (; *cursor < world->pairs_capacity; (*cursor)++) {
+		const struct world_pair_t* pair = &world->pairs[*cursor];
+		if (pair->a != EMPTY_PAIR && !pair_stale(world, pair) && pair->colliding) {
+			(*cursor)++;
+			return pair;
+		}
+	}
+
+	return NULL;
+}
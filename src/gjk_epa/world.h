@@ -0,0 +1,183 @@
+/**
+ * Keeps the results of every pair of shapes between ticks, so only pairs with a shape that moved run GJK and EPA again.
+ *
+ * Every shape has a version that is bumped by world_shape_moved. A pair's result is cached with the versions of both
+ * of its shapes, and world_step only looks at the shapes that moved since the last step, so the narrow phase cost
+ * scales with the number of moving shapes. Static and sleeping shapes cost nothing until something moves near them.
+ *
+ * The broad phase is a uniform grid of cell_size cells stored in a hash table, with every shape listed in each cell
+ * its bounds touch. A moved shape is only checked against the shapes listed in its own cells. Shapes covering more than
+ * WORLD_MAX_SHAPE_CELLS cells are kept out of the grid and checked against every moved shape instead.
+ *
+ * The world doesn't own the points of its polygons. Change them in place and call world_shape_moved.
+ */
+
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "vector.h"
+#include "epa.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default world->cell_size, a few times the size of a typical small shape
+#define WORLD_DEFAULT_CELL_SIZE 64
+
+#ifndef WORLD_MAX_SHAPE_CELLS
+// Bigger shapes would take more time to list in and look up in the grid than to check against every moved shape
+#define WORLD_MAX_SHAPE_CELLS 64
+#endif
+
+enum world_flags_t {
+	// Pairs with a sleeping shape aren't checked at all, and their cached results are dropped when the other shape moves
+	WORLD_SKIP_SLEEPING = 1 << 0,
+};
+
+/**
+ * Range of grid cells, min and max included. Empty when max_x < min_x
+ */
+struct world_cells_t {
+	int min_x;
+	int min_y;
+	int max_x;
+	int max_y;
+};
+
+struct world_shape_t {
+	struct polygon_t poly;
+	struct aabb_t bounds;
+	uint32_t version;
+	bool sleeping;
+	bool dirty;
+
+	// Cells the shape is listed in, from its bounds at the last step
+	struct world_cells_t cells;
+	// Too big for the grid, see WORLD_MAX_SHAPE_CELLS
+	bool big;
+	// Last moved shape that found this one in the grid, so shapes in several cells are only checked once
+	uint32_t visit;
+};
+
+/**
+ * Entry of the linked list of shapes in a bucket of the grid's hash table
+ */
+struct world_cell_entry_t {
+	int shape;
+	int next;
+};
+
+/**
+ * Cached result of a pair of shapes a < b, valid while both shapes are still at version_a and version_b
+ */
+struct world_pair_t {
+	int a;
+	int b;
+	uint32_t version_a;
+	uint32_t version_b;
+	bool colliding;
+	struct vector_t penetration;
+	struct epa_cache_t epa_cache;
+};
+
+struct world_stats_t {
+	// Pairs whose bounds overlap that were looked at by the last step
+	int pairs_checked;
+	// Pairs that ran GJK (and EPA if they collide) in the last step, the others reused their cached result
+	int pairs_computed;
+};
+
+struct world_t {
+	struct world_shape_t* shapes;
+	int num_shapes;
+	int shapes_capacity;
+
+	// Shapes that moved since the last step
+	int* dirty;
+	int num_dirty;
+
+	// Open addressing hash table of pairs whose bounds overlapped when they were last checked
+	struct world_pair_t* pairs;
+	int num_pairs;
+	int pairs_capacity;
+
+	// Side of a grid cell. Change it before adding the first shape
+	scalar_t cell_size;
+	// Hash table of the grid's cells, each bucket the first entry of a list in cell_entries or -1. Cells that share a
+	// bucket share the list, which only costs a bounds check for their shapes
+	int* cell_buckets;
+	int num_cell_buckets;
+	struct world_cell_entry_t* cell_entries;
+	int num_cell_entries;
+	int cell_entries_capacity;
+	// Removed entries, linked through next
+	int free_cell_entry;
+
+	// Shapes too big for the grid
+	int* big;
+	int num_big;
+	uint32_t visit;
+
+	int flags;
+	struct world_stats_t stats;
+};
+
+/**
+ * @param flags zero or more of enum world_flags_t
+ */
+void world_init(struct world_t* world, int flags);
+
+void world_free(struct world_t* world);
+
+/**
+ * Adds a shape, which counts as moved until the next step
+ *
+ * @return id of the shape, or -1 if out of memory
+ */
+int world_add_shape(struct world_t* world, struct polygon_t poly);
+
+/**
+ * Marks that the shape's points changed. Don't call it for shapes that didn't move, since that's what lets
+ * their pairs be skipped
+ */
+void world_shape_moved(struct world_t* world, int id);
+
+/**
+ * Sleeping shapes keep their cached pairs, and are left out of pairing completely with WORLD_SKIP_SLEEPING.
+ * Waking a shape up counts as moving it
+ */
+void world_set_sleeping(struct world_t* world, int id, bool sleeping);
+
+/**
+ * Updates the results of every pair with a shape that moved since the last step. Every moved shape is checked against
+ * the bounds of the shapes in its grid cells, and only pairs that overlap and changed run GJK and EPA (see world->stats)
+ */
+void world_step(struct world_t* world);
+
+/**
+ * Looks up the result of a pair from the last step
+ *
+ * @param penetration receives the penetration vector like collision_penetration(a, b) if it isn't NULL, (0, 0) if they don't collide
+ * @return true if the shapes collide
+ */
+bool world_pair_colliding(const struct world_t* world, int a, int b, struct vector_t* penetration);
+
+/**
+ * Iterates over the colliding pairs from the last step:
+ *
+ *   int cursor = 0;
+ *   const struct world_pair_t* pair;
+ *   while ((pair = world_next_contact(world, &cursor)) != NULL) { ... }
+ *
+ * @return next colliding pair, or NULL after the last one
+ */
+const struct world_pair_t* world_next_contact(const struct world_t* world, int* cursor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,6 +2,7 @@
 
 // SDL2 rendering code based on https://web.dev/articles/drawing-to-canvas-in-emscripten
 #include <stdbool.h>
+#include <stdlib.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 
 #ifdef __EMSCRIPTEN__
@@ -11,7 +12,9 @@
 #include "gjk_epa/fixed_point.h"
 #include "gjk_epa/gjk.h"
 #include "gjk_epa/epa.h"
+#include "gjk_epa/collision.h"
 #include "gjk_epa/utils.h"
+#include "gjk_epa/recorder.h"
 #include "loop.h"
 
 // Set up polygons
@@ -150,12 +153,15 @@ bool handle_events() {
 		convert_to_polygon_t(points1, NUM_POINTS_1, &gjk_poly1);
 		convert_to_polygon_t(points2, NUM_POINTS_2, &gjk_poly2);
 
-		struct vector_t penetration_vector = epa(gjk_poly1, gjk_poly2);
+		// One GJK run for the boolean, and EPA reuses its simplex
+		struct collision_t collision;
+		bool colliding = recorded_collide(gjk_poly1, gjk_poly2, &collision);
+
+		struct vector_t penetration_vector = collision_penetration(&collision);
 		printf("penetration vector: x: %ld + %ld/%d\n", fixed_point_to_int(penetration_vector.x), get_remainder(penetration_vector.x), FIXED_POINT_SCALING_FACTOR);
 		printf("penetration vector: y: %ld + %ld/%d\n", fixed_point_to_int(penetration_vector.y), get_remainder(penetration_vector.y), FIXED_POINT_SCALING_FACTOR);
 		puts("");
 
-		bool colliding = gjk_collision(gjk_poly1, gjk_poly2, NULL);
 		int64_t offset_x = fixed_point_to_int(penetration_vector.x);
 		int64_t offset_y = fixed_point_to_int(penetration_vector.y);
 		if (colliding) {
@@ -173,6 +179,9 @@ bool handle_events() {
 		}
 
 		redraw(colliding);
+
+		// Outside of the queries, for builds without the recorder's writer thread
+		recorder_flush();
 	}
 
 	return true;
@@ -183,11 +192,19 @@ void call_handle_events(void) {
 }
 
 void run_main_loop(void) {
+	// Set GJK_RECORD=file to record every query for tools/replay.c
+	const char* record_path = getenv("GJK_RECORD");
+	if (record_path != NULL) {
+		recorder_start(record_path, 0);
+	}
+
 #ifdef __EMSCRIPTEN__
 	emscripten_set_main_loop(call_handle_events, 0, true);
 #else
 	while (handle_events())
 		;
 #endif
+
+	recorder_stop();
 }
 #endif
@@ -58,6 +58,8 @@ void redraw() {
 
 void run_main_loop()  {
 	int x = 100, y = 100;
+	// Redrawing the whole screen is the slowest part of a frame, so only do it when polygon 2 moved
+	bool moved = true;
 	do
 	{
 		kb_key_t arrows;
@@ -71,6 +73,7 @@ void run_main_loop()  {
 		/* Check if any arrows are pressed */
 		if (arrows)
 		{
+			moved = true;
 			int dx = 3, dy = 3;
 			/* Do different directions depending on the keypress */
 			if (arrows & kb_Right)
@@ -91,6 +94,11 @@ void run_main_loop()  {
 			}
 		}
 
+		if (!moved) {
+			continue;
+		}
+		moved = false;
+
 		/* Update Polygon 2 */
 		points2[0] = x,    points2[1] = y-30;  // (x0, y0)
 		points2[2] = x-30, points2[3] = y-10;  // (x1, y1)
@@ -2,27 +2,45 @@
 
 #include <graphx.h>
 #include "loop_ti84pce.h"
+#include "bench_ti84pce.h"
 
 #else
 
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <SDL2/SDL.h>
 #include "loop.h"
+#include "stress.h"
 
 #endif
 
-int main(void) {
+int main(int argc, char** argv) {
 #ifdef TI84PCE
 	gfx_Begin();
 	gfx_SetDrawBuffer();
 
+#ifdef BENCHMARK
+	run_benchmark();
+#else
 	run_main_loop();
+#endif
 
 	gfx_End();
 #else
+	// --stress [shapes] runs the stress test instead of the two polygon demo
+	bool stress = argc > 1 && strcmp(argv[1], "--stress") == 0;
+	int num_shapes = argc > 2 ? atoi(argv[2]) : STRESS_DEFAULT_SHAPES;
+
 	SDL_Init(SDL_INIT_VIDEO);
-	SDL_CreateWindowAndRenderer(320, 240, 0, &window, &renderer);
 
-	run_main_loop();
+	if (stress) {
+		SDL_CreateWindowAndRenderer(STRESS_WIDTH, STRESS_HEIGHT, 0, &window, &renderer);
+		run_stress_loop(num_shapes > 0 ? num_shapes : STRESS_DEFAULT_SHAPES);
+	} else {
+		SDL_CreateWindowAndRenderer(320, 240, 0, &window, &renderer);
+		run_main_loop();
+	}
 
 	SDL_DestroyRenderer(renderer);
 	SDL_DestroyWindow(window);
@@ -0,0 +1,412 @@
+#ifndef TI84PCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL2_gfxPrimitives.h>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+#include "gjk_epa/batch.h"
+#include "loop.h"
+#include "stress.h"
+
+#define MIN_POINTS 3
+#define MAX_POINTS 8
+#define MIN_RADIUS 2
+#define MAX_RADIUS 10
+
+// Weight of the newest frame in the timings shown on the overlay
+#define SMOOTHING 0.05
+
+enum phase_t {
+	PHASE_MOVE,
+	PHASE_BROAD,
+	PHASE_NARROW,
+	PHASE_DRAW,
+	PHASE_FRAME,
+
+	NUM_PHASES
+};
+
+static const char* PHASE_NAMES[NUM_PHASES] = {
+	"move",
+	"broad phase",
+	"narrow phase",
+	"draw",
+	"frame",
+};
+
+// The shapes are packed the way the batch API wants them (see struct batch_polygons_t)
+static struct {
+	int num_shapes;
+	int32_t* coords;
+	int32_t* offsets;
+	int32_t* velocities;
+	int32_t* bounds;     // (min x, min y, max x, max y) of every shape
+	bool* colliding;
+
+	// Uniform grid with cells as big as the biggest shape, so a shape can only touch shapes from the 3x3 cells around it
+	int cell_size;
+	int cells_x;
+	int cells_y;
+	int* cell_start;
+	int* cell_shapes;
+
+	int32_t* pairs;
+	uint8_t* hits;
+	int32_t* penetrations;
+	int num_pairs;
+	int pairs_capacity;
+	int num_hits;
+	bool penetration_enabled;
+
+	SDL_Vertex* vertices;
+	int num_vertices;
+
+	double timings[NUM_PHASES];
+	Uint64 frame_start;
+} stress;
+
+static double elapsed_ms(Uint64 start) {
+	return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+static void record_timing(enum phase_t phase, Uint64 start) {
+	stress.timings[phase] += SMOOTHING * (elapsed_ms(start) - stress.timings[phase]);
+}
+
+static int random_between(int low, int high) {
+	return low + rand() % (high - low + 1);
+}
+
+static void update_bounds(int i) {
+	int32_t* coords = stress.coords + 2*stress.offsets[i];
+	int num_points = stress.offsets[i+1] - stress.offsets[i];
+	int32_t* b = stress.bounds + 4*i;
+
+	b[0] = b[2] = coords[0];
+	b[1] = b[3] = coords[1];
+	for (int k = 1; k < num_points; k++) {
+		int32_t x = coords[2*k], y = coords[2*k+1];
+		if (x < b[0]) b[0] = x;
+		if (y < b[1]) b[1] = y;
+		if (x > b[2]) b[2] = x;
+		if (y > b[3]) b[3] = y;
+	}
+}
+
+static bool spawn_shapes(int num_shapes) {
+	// Smaller shapes when there are many of them, so the window doesn't turn into one big pile
+	int max_radius = (int)sqrt((double)STRESS_WIDTH * STRESS_HEIGHT / num_shapes) / 2;
+	if (max_radius > MAX_RADIUS) max_radius = MAX_RADIUS;
+	if (max_radius < MIN_RADIUS + 1) max_radius = MIN_RADIUS + 1;
+
+	stress.num_shapes = num_shapes;
+	stress.coords = malloc(2 * MAX_POINTS * num_shapes * sizeof(int32_t));
+	stress.offsets = malloc((num_shapes + 1) * sizeof(int32_t));
+	stress.velocities = malloc(2 * num_shapes * sizeof(int32_t));
+	stress.bounds = malloc(4 * num_shapes * sizeof(int32_t));
+	stress.colliding = calloc(num_shapes, sizeof(bool));
+
+	stress.cell_size = 2 * max_radius;
+	stress.cells_x = (STRESS_WIDTH + stress.cell_size - 1) / stress.cell_size;
+	stress.cells_y = (STRESS_HEIGHT + stress.cell_size - 1) / stress.cell_size;
+	stress.cell_start = malloc((stress.cells_x * stress.cells_y + 1) * sizeof(int));
+	stress.cell_shapes = malloc(num_shapes * sizeof(int));
+
+	// Every shape is drawn as a triangle fan
+	stress.vertices = malloc(3 * (MAX_POINTS - 2) * num_shapes * sizeof(SDL_Vertex));
+
+	if (stress.coords == NULL || stress.offsets == NULL || stress.velocities == NULL || stress.bounds == NULL
+			|| stress.colliding == NULL || stress.cell_start == NULL || stress.cell_shapes == NULL || stress.vertices == NULL) {
+		return false;
+	}
+
+	int k = 0;
+	stress.offsets[0] = 0;
+	for (int i = 0; i < num_shapes; i++) {
+		int num_points = random_between(MIN_POINTS, MAX_POINTS);
+		int radius = random_between(MIN_RADIUS, max_radius);
+		int cx = random_between(radius, STRESS_WIDTH - 1 - radius);
+		int cy = random_between(radius, STRESS_HEIGHT - 1 - radius);
+		double phase = 2 * M_PI * rand() / RAND_MAX;
+
+		for (int p = 0; p < num_points; p++, k++) {
+			double angle = phase + 2 * M_PI * p / num_points;
+			stress.coords[2*k] = cx + (int32_t)lround(radius * cos(angle));
+			stress.coords[2*k+1] = cy + (int32_t)lround(radius * sin(angle));
+		}
+		stress.offsets[i+1] = k;
+
+		do {
+			stress.velocities[2*i] = random_between(-2, 2);
+			stress.velocities[2*i+1] = random_between(-2, 2);
+		} while (stress.velocities[2*i] == 0 && stress.velocities[2*i+1] == 0);
+
+		update_bounds(i);
+	}
+
+	return true;
+}
+
+static void free_shapes(void) {
+	free(stress.coords);
+	free(stress.offsets);
+	free(stress.velocities);
+	free(stress.bounds);
+	free(stress.colliding);
+	free(stress.cell_start);
+	free(stress.cell_shapes);
+	free(stress.pairs);
+	free(stress.hits);
+	free(stress.penetrations);
+	free(stress.vertices);
+}
+
+static void move_shapes(void) {
+	for (int i = 0; i < stress.num_shapes; i++) {
+		int32_t* v = stress.velocities + 2*i;
+		int32_t* b = stress.bounds + 4*i;
+
+		// Bounce off the edges of the window
+		if (b[0] + v[0] < 0 || b[2] + v[0] >= STRESS_WIDTH) v[0] = -v[0];
+		if (b[1] + v[1] < 0 || b[3] + v[1] >= STRESS_HEIGHT) v[1] = -v[1];
+
+		for (int k = stress.offsets[i]; k < stress.offsets[i+1]; k++) {
+			stress.coords[2*k] += v[0];
+			stress.coords[2*k+1] += v[1];
+		}
+		b[0] += v[0];
+		b[1] += v[1];
+		b[2] += v[0];
+		b[3] += v[1];
+	}
+}
+
+static int cell_of(int i) {
+	int32_t* b = stress.bounds + 4*i;
+	int cx = (b[0] + b[2]) / 2 / stress.cell_size;
+	int cy = (b[1] + b[3]) / 2 / stress.cell_size;
+	return cy * stress.cells_x + cx;
+}
+
+static bool add_pair(int a, int b) {
+	if (stress.num_pairs == stress.pairs_capacity) {
+		int capacity = stress.pairs_capacity == 0 ? 1024 : 2 * stress.pairs_capacity;
+
+		int32_t* pairs = realloc(stress.pairs, 2 * capacity * sizeof(int32_t));
+		uint8_t* hits = realloc(stress.hits, capacity * sizeof(uint8_t));
+		int32_t* penetrations = realloc(stress.penetrations, 2 * capacity * sizeof(int32_t));
+		if (pairs != NULL) stress.pairs = pairs;
+		if (hits != NULL) stress.hits = hits;
+		if (penetrations != NULL) stress.penetrations = penetrations;
+		if (pairs == NULL || hits == NULL || penetrations == NULL) {
+			return false;
+		}
+		stress.pairs_capacity = capacity;
+	}
+
+	stress.pairs[2*stress.num_pairs] = a;
+	stress.pairs[2*stress.num_pairs+1] = b;
+	stress.num_pairs++;
+	return true;
+}
+
+static void find_pairs(void) {
+	int num_cells = stress.cells_x * stress.cells_y;
+
+	// Counting sort of the shapes by cell
+	for (int c = 0; c <= num_cells; c++) {
+		stress.cell_start[c] = 0;
+	}
+	for (int i = 0; i < stress.num_shapes; i++) {
+		stress.cell_start[cell_of(i) + 1]++;
+	}
+	for (int c = 0; c < num_cells; c++) {
+		stress.cell_start[c+1] += stress.cell_start[c];
+	}
+	for (int i = 0; i < stress.num_shapes; i++) {
+		stress.cell_shapes[stress.cell_start[cell_of(i)]++] = i;
+	}
+	// Placing the shapes moved every start up to the next cell's
+	for (int c = num_cells; c > 0; c--) {
+		stress.cell_start[c] = stress.cell_start[c-1];
+	}
+	stress.cell_start[0] = 0;
+
+	stress.num_pairs = 0;
+	for (int a = 0; a < stress.num_shapes; a++) {
+		int32_t* ba = stress.bounds + 4*a;
+		int cell = cell_of(a);
+		int cx = cell % stress.cells_x, cy = cell / stress.cells_x;
+
+		for (int y = cy - 1; y <= cy + 1; y++) {
+			for (int x = cx - 1; x <= cx + 1; x++) {
+				if (x < 0 || y < 0 || x >= stress.cells_x || y >= stress.cells_y) {
+					continue;
+				}
+
+				int c = y * stress.cells_x + x;
+				for (int k = stress.cell_start[c]; k < stress.cell_start[c+1]; k++) {
+					int b = stress.cell_shapes[k];
+					int32_t* bb = stress.bounds + 4*b;
+
+					// Every pair is seen from both shapes, so only keep it once
+					if (b <= a || ba[0] > bb[2] || bb[0] > ba[2] || ba[1] > bb[3] || bb[1] > ba[3]) {
+						continue;
+					}
+					if (!add_pair(a, b)) {
+						return;
+					}
+				}
+			}
+		}
+	}
+}
+
+static void check_pairs(void) {
+	struct batch_polygons_t polys = {
+		.coords = stress.coords,
+		.offsets = stress.offsets,
+		.num_polygons = stress.num_shapes,
+	};
+	int32_t* penetrations = stress.penetration_enabled ? stress.penetrations : NULL;
+
+#ifdef GJK_PTHREADS
+	stress.num_hits = batch_collision_parallel(polys, stress.pairs, stress.num_pairs, stress.hits, penetrations, SDL_GetCPUCount());
+#else
+	stress.num_hits = batch_collision(polys, stress.pairs, stress.num_pairs, stress.hits, penetrations);
+#endif
+
+	for (int i = 0; i < stress.num_shapes; i++) {
+		stress.colliding[i] = false;
+	}
+	for (int i = 0; i < stress.num_pairs; i++) {
+		if (stress.hits[i]) {
+			stress.colliding[stress.pairs[2*i]] = true;
+			stress.colliding[stress.pairs[2*i+1]] = true;
+		}
+	}
+}
+
+static void draw_overlay(void) {
+	char line[128];
+	int y = 4;
+
+	boxRGBA(renderer, 0, 0, 270, 4 + 10 * (NUM_PHASES + 3), 0x00, 0x00, 0x00, 0xC0);
+
+	snprintf(line, sizeof(line), "%d shapes, %d pairs, %d hits", stress.num_shapes, stress.num_pairs, stress.num_hits);
+	stringRGBA(renderer, 4, y, line, 0xFF, 0xFF, 0xFF, 0xFF);
+	y += 10;
+
+	for (int p = 0; p < NUM_PHASES; p++) {
+		snprintf(line, sizeof(line), "%-13s %7.2f ms", PHASE_NAMES[p], stress.timings[p]);
+		stringRGBA(renderer, 4, y, line, 0xFF, 0xFF, 0xFF, 0xFF);
+		y += 10;
+	}
+
+	double narrow_s = stress.timings[PHASE_NARROW] / 1000.0;
+	snprintf(line, sizeof(line), "%.2f M pairs/s", narrow_s > 0 ? stress.num_pairs / narrow_s / 1e6 : 0.0);
+	stringRGBA(renderer, 4, y, line, 0xFF, 0xFF, 0xFF, 0xFF);
+	y += 10;
+
+	snprintf(line, sizeof(line), "EPA %s (press E)", stress.penetration_enabled ? "on" : "off");
+	stringRGBA(renderer, 4, y, line, 0xFF, 0xFF, 0xFF, 0xFF);
+}
+
+static void draw_shapes(void) {
+	const SDL_Color green = {0x00, 0xFF, 0x00, 0xFF};
+	const SDL_Color red = {0xFF, 0x00, 0x00, 0xFF};
+	int n = 0;
+
+	for (int i = 0; i < stress.num_shapes; i++) {
+		SDL_Color color = stress.colliding[i] ? red : green;
+		int first = stress.offsets[i];
+
+		for (int k = first + 1; k + 1 < stress.offsets[i+1]; k++) {
+			int fan[3] = {first, k, k + 1};
+			for (int v = 0; v < 3; v++) {
+				stress.vertices[n++] = (SDL_Vertex) {
+					.position = {(float)stress.coords[2*fan[v]], (float)stress.coords[2*fan[v]+1]},
+					.color = color,
+				};
+			}
+		}
+	}
+	stress.num_vertices = n;
+
+	SDL_SetRenderDrawColor(renderer, /* RGBA: black */ 0x00, 0x00, 0x00, 0x00);
+	SDL_RenderClear(renderer);
+
+	// All of the shapes in one draw call
+	SDL_RenderGeometry(renderer, NULL, stress.vertices, stress.num_vertices, NULL, 0);
+}
+
+static bool stress_frame(void) {
+	SDL_Event event;
+	while (SDL_PollEvent(&event)) {
+		if (event.type == SDL_QUIT || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE)) {
+			return false;
+		}
+		if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_e) {
+			stress.penetration_enabled = !stress.penetration_enabled;
+		}
+	}
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	move_shapes();
+	record_timing(PHASE_MOVE, start);
+
+	start = SDL_GetPerformanceCounter();
+	find_pairs();
+	record_timing(PHASE_BROAD, start);
+
+	start = SDL_GetPerformanceCounter();
+	check_pairs();
+	record_timing(PHASE_NARROW, start);
+
+	start = SDL_GetPerformanceCounter();
+	draw_shapes();
+	record_timing(PHASE_DRAW, start);
+
+	// Frame time is from one present to the next, so it includes waiting for vsync
+	if (stress.frame_start != 0) {
+		record_timing(PHASE_FRAME, stress.frame_start);
+	}
+	stress.frame_start = SDL_GetPerformanceCounter();
+
+	draw_overlay();
+	SDL_RenderPresent(renderer);
+
+	return true;
+}
+
+#ifdef __EMSCRIPTEN__
+static void call_stress_frame(void) {
+	stress_frame();
+}
+#endif
+
+void run_stress_loop(int num_shapes) {
+	if (!spawn_shapes(num_shapes)) {
+		fprintf(stderr, "ERROR: Couldn't allocate %d shapes\n", num_shapes);
+		free_shapes();
+		return;
+	}
+
+#ifdef __EMSCRIPTEN__
+	emscripten_set_main_loop(call_stress_frame, 0, true);
+#else
+	while (stress_frame())
+		;
+#endif
+
+	free_shapes();
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef STRESS_H
+#define STRESS_H
+
+#ifndef TI84PCE
+
+#define STRESS_WIDTH 1280
+#define STRESS_HEIGHT 720
+#define STRESS_DEFAULT_SHAPES 1000
+
+/**
+ * Stress test demo: num_shapes small convex shapes bounce around the window and every pair close enough to touch goes
+ * through the batch API each frame. An overlay shows the time spent in each phase.
+ * Uses the window and renderer from loop.h
+ */
+void run_stress_loop(int num_shapes);
+
+#endif
+
+#endif
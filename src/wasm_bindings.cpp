@@ -0,0 +1,40 @@
+// JavaScript bindings for the library only WebASM build (`make wasm-lib`)
+//
+// All arguments are byte offsets into the wasm heap (e.g. from Module._malloc),
+// so JS fills typed arrays over Module.HEAP32/HEAPU8 and nothing gets copied per call.
+#ifdef __EMSCRIPTEN__
+#include <cstdint>
+#include <emscripten/bind.h>
+
+#include "gjk_epa/batch.h"
+
+int batch_collision_js(uintptr_t coords, uintptr_t offsets, int num_polygons, uintptr_t pairs, int num_pairs, uintptr_t hits, uintptr_t penetrations) {
+	struct batch_polygons_t polys;
+	polys.coords = reinterpret_cast<const int32_t*>(coords);
+	polys.offsets = reinterpret_cast<const int32_t*>(offsets);
+	polys.num_polygons = num_polygons;
+
+	return batch_collision(polys, reinterpret_cast<const int32_t*>(pairs), num_pairs,
+			reinterpret_cast<uint8_t*>(hits), reinterpret_cast<int32_t*>(penetrations));
+}
+
+#ifdef GJK_PTHREADS
+int batch_collision_parallel_js(uintptr_t coords, uintptr_t offsets, int num_polygons, uintptr_t pairs, int num_pairs, uintptr_t hits, uintptr_t penetrations, int num_threads) {
+	struct batch_polygons_t polys;
+	polys.coords = reinterpret_cast<const int32_t*>(coords);
+	polys.offsets = reinterpret_cast<const int32_t*>(offsets);
+	polys.num_polygons = num_polygons;
+
+	return batch_collision_parallel(polys, reinterpret_cast<const int32_t*>(pairs), num_pairs,
+			reinterpret_cast<uint8_t*>(hits), reinterpret_cast<int32_t*>(penetrations), num_threads);
+}
+#endif
+
+EMSCRIPTEN_BINDINGS(gjk_epa) {
+	emscripten::function("batchCollision", &batch_collision_js);
+#ifdef GJK_PTHREADS
+	emscripten::function("batchCollisionParallel", &batch_collision_parallel_js);
+	emscripten::constant("BATCH_MAX_THREADS", BATCH_MAX_THREADS);
+#endif
+}
+#endif
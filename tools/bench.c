@@ -0,0 +1,1041 @@
+/**
+ * Benchmarks for the collision queries on synthetic scenes
+ *
+ * Usage: bench [-f frames] [scene...]
+ *   -f  number of frames every scene is simulated for (default 200)
+ *   With no scene names every scene runs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "gjk_epa/gjk.h"
+#include "gjk_epa/epa.h"
+#include "gjk_epa/collision.h"
+#include "gjk_epa/world.h"
+#include "gjk_epa/sat.h"
+#include "gjk_epa/shape.h"
+#include "gjk_epa/compact.h"
+#include "gjk_epa/shapedb.h"
+#include "gjk_epa/mpr.h"
+#include "gjk_epa/tilemap.h"
+#include "gjk_epa/query.h"
+#include "gjk_epa/batch.h"
+#include "gjk_epa/fixed_point.h"
+
+#define MAX_POINTS 16
+#define NUM_PAIRS 1000
+#define NUM_SHAPES 2000
+
+struct pair_t {
+	struct vector_t points1[MAX_POINTS];
+	struct vector_t points2[MAX_POINTS];
+	struct polygon_t poly1;
+	struct polygon_t poly2;
+};
+
+struct result_t {
+	int64_t ns;
+	long queries;
+	long hits;
+	long iterations;
+};
+
+static int num_frames = 200;
+
+static int64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void print_result(const char* scene, const char* query, struct result_t r) {
+	printf("%-10s %-28s %9ld queries %8.1f ns/query %6.2f iterations/hit %6.1f%% hits\n", scene, query, r.queries,
+			(double)r.ns / r.queries, r.hits ? (double)r.iterations / r.hits : 0.0, 100.0 * r.hits / r.queries);
+}
+
+static void make_box(struct vector_t* points, scalar_t x, scalar_t y, scalar_t w, scalar_t h) {
+	points[0] = (struct vector_t){x, y};
+	points[1] = (struct vector_t){x, y + h};
+	points[2] = (struct vector_t){x + w, y + h};
+	points[3] = (struct vector_t){x + w, y};
+}
+
+static void make_round(struct vector_t* points, int num_points, scalar_t x, scalar_t y, scalar_t r) {
+	for (int i = 0; i < num_points; i++) {
+		double angle = 2 * M_PI * i / num_points;
+		points[i] = (struct vector_t){x + (scalar_t)lround(r * cos(angle)), y + (scalar_t)lround(r * sin(angle))};
+	}
+}
+
+static void translate(struct polygon_t poly, scalar_t dx, scalar_t dy) {
+	for (int i = 0; i < poly.num_points; i++) {
+		poly.points[i].x += dx;
+		poly.points[i].y += dy;
+	}
+}
+
+/*
+ * Shapes resting on a wide floor or on each other with a few pixels of overlap, like a stack the solver keeps pushing
+ * apart every frame. Every frame the top shape jitters by a pixel.
+ */
+static struct pair_t* make_resting_scene(void) {
+	struct pair_t* pairs = malloc(NUM_PAIRS * sizeof(struct pair_t));
+
+	for (int i = 0; i < NUM_PAIRS; i++) {
+		struct pair_t* p = &pairs[i];
+		scalar_t x = 50 + rand() % 300;
+		scalar_t overlap = 1 + rand() % 3;
+
+		if (i % 3 == 0) {
+			// Box on the floor
+			scalar_t w = 10 + rand() % 40;
+			scalar_t h = 10 + rand() % 40;
+			p->poly1 = (struct polygon_t){p->points1, 4};
+			make_box(p->points1, 0, 100, 400, 40);
+			p->poly2 = (struct polygon_t){p->points2, 4};
+			make_box(p->points2, x, 100 - h + overlap, w, h);
+		} else if (i % 3 == 1) {
+			// Round shape on the floor
+			scalar_t r = 10 + rand() % 40;
+			p->poly1 = (struct polygon_t){p->points1, 4};
+			make_box(p->points1, 0, 100, 400, 40);
+			p->poly2 = (struct polygon_t){p->points2, MAX_POINTS};
+			make_round(p->points2, MAX_POINTS, x, 100 - r + overlap, r);
+		} else {
+			// Round shape leaning on another one, so the contact normal isn't axis aligned
+			scalar_t r1 = 10 + rand() % 40;
+			scalar_t r2 = 10 + rand() % 40;
+			double angle = M_PI / 8 + (M_PI / 4) * (rand() % 100) / 100.0;
+			double distance = r1 + r2 - overlap;
+			p->poly1 = (struct polygon_t){p->points1, MAX_POINTS};
+			make_round(p->points1, MAX_POINTS, x, 100, r1);
+			p->poly2 = (struct polygon_t){p->points2, MAX_POINTS};
+			make_round(p->points2, MAX_POINTS, x + (scalar_t)lround(distance * cos(angle)), 100 - (scalar_t)lround(distance * sin(angle)), r2);
+		}
+	}
+
+	return pairs;
+}
+
+static void jitter(struct pair_t* pairs, int frame) {
+	for (int i = 0; i < NUM_PAIRS; i++) {
+		translate(pairs[i].poly2, (frame + i) % 2 ? 1 : -1, 0);
+	}
+}
+
+static void bench_resting(void) {
+	srand(1);
+	struct pair_t* pairs = make_resting_scene();
+	struct epa_cache_t* caches = calloc(NUM_PAIRS, sizeof(struct epa_cache_t));
+	struct result_t gjk = {0}, cold = {0}, warm = {0};
+	long differences = 0;
+
+	for (int frame = 0; frame < num_frames; frame++) {
+		jitter(pairs, frame);
+
+		for (int i = 0; i < NUM_PAIRS; i++) {
+			struct collision_t collision;
+
+			int64_t start = now_ns();
+			collide(pairs[i].poly1, pairs[i].poly2, &collision);
+			gjk.ns += now_ns() - start;
+			gjk.queries++;
+			gjk.hits += collision.colliding;
+			gjk.iterations += collision.gjk_iterations;
+
+			start = now_ns();
+			collide(pairs[i].poly1, pairs[i].poly2, &collision);
+			struct vector_t p_cold = collision_penetration(&collision);
+			cold.ns += now_ns() - start;
+			cold.queries++;
+			cold.hits += collision.colliding;
+			cold.iterations += collision.epa_iterations;
+
+			start = now_ns();
+			collide(pairs[i].poly1, pairs[i].poly2, &collision);
+			struct vector_t p_warm = collision_penetration_cached(&collision, &caches[i]);
+			warm.ns += now_ns() - start;
+			warm.queries++;
+			warm.hits += collision.colliding;
+			warm.iterations += collision.epa_iterations;
+
+			differences += p_cold.x != p_warm.x || p_cold.y != p_warm.y;
+		}
+	}
+
+	print_result("resting", "collide", gjk);
+	print_result("resting", "collide + EPA", cold);
+	print_result("resting", "collide + warm started EPA", warm);
+	// Only where two edges are equally close, e.g. the mirrored edges of round shapes
+	printf("%-10s warm started penetration differs from cold in %ld queries\n", "resting", differences);
+
+	free(caches);
+	free(pairs);
+}
+
+/*
+ * Shapes scattered so that each one touches a few neighbours, where only one in MOVING_EVERY moves every frame.
+ * Compares checking every pair of shapes every frame against world_step, which skips the pairs that didn't change
+ */
+#define MOVING_EVERY 20
+
+struct static_shape_t {
+	struct vector_t points[MAX_POINTS];
+	struct polygon_t poly;
+};
+
+static void bench_static(void) {
+	srand(2);
+	struct static_shape_t* shapes = malloc(NUM_SHAPES * sizeof(struct static_shape_t));
+	for (int i = 0; i < NUM_SHAPES; i++) {
+		scalar_t x = rand() % 2000, y = rand() % 2000;
+		scalar_t size = 20 + rand() % 30;
+		if (i % 2 == 0) {
+			shapes[i].poly = (struct polygon_t){shapes[i].points, 4};
+			make_box(shapes[i].points, x, y, size, size);
+		} else {
+			shapes[i].poly = (struct polygon_t){shapes[i].points, MAX_POINTS};
+			make_round(shapes[i].points, MAX_POINTS, x, y, size / 2);
+		}
+	}
+
+	struct world_t world;
+	world_init(&world, 0);
+	for (int i = 0; i < NUM_SHAPES; i++) {
+		world_add_shape(&world, shapes[i].poly);
+	}
+	world_step(&world);
+
+	struct aabb_t* bounds = malloc(NUM_SHAPES * sizeof(struct aabb_t));
+	struct result_t all = {0}, cached = {0};
+	long computed = 0, differences = 0;
+
+	for (int frame = 0; frame < num_frames; frame++) {
+		for (int i = frame % MOVING_EVERY; i < NUM_SHAPES; i += MOVING_EVERY) {
+			translate(shapes[i].poly, (frame / MOVING_EVERY + i) % 2 ? 1 : -1, 0);
+			world_shape_moved(&world, i);
+		}
+
+		int64_t start = now_ns();
+		world_step(&world);
+		cached.ns += now_ns() - start;
+		cached.queries += world.stats.pairs_checked;
+		computed += world.stats.pairs_computed;
+
+		// Every pair with overlapping bounds, from scratch
+		start = now_ns();
+		for (int i = 0; i < NUM_SHAPES; i++) {
+			bounds[i] = get_aabb(shapes[i].poly);
+		}
+		for (int a = 0; a < NUM_SHAPES; a++) {
+			for (int b = a + 1; b < NUM_SHAPES; b++) {
+				if (!aabb_overlap(bounds[a], bounds[b])) {
+					continue;
+				}
+
+				struct collision_t collision;
+				collide(shapes[a].poly, shapes[b].poly, &collision);
+				collision_penetration(&collision);
+				all.queries++;
+				all.hits += collision.colliding;
+				all.iterations += collision.gjk_iterations + collision.epa_iterations;
+
+				differences += collision.colliding != world_pair_colliding(&world, a, b, NULL);
+			}
+		}
+		all.ns += now_ns() - start;
+	}
+
+	printf("%-10s %-28s %9ld pairs    %8.1f us/frame\n", "static", "every pair", all.queries, all.ns / 1e3 / num_frames);
+	printf("%-10s %-28s %9ld pairs    %8.1f us/frame %ld pairs ran GJK\n", "static", "world_step", cached.queries,
+			cached.ns / 1e3 / num_frames, computed);
+	printf("%-10s world_step disagrees with every pair in %ld pairs\n", "static", differences);
+
+	world_free(&world);
+	free(bounds);
+	free(shapes);
+}
+
+/*
+ * Random convex polygons close enough to each other that about half of the pairs collide.
+ * With boxes set the polygons are axis aligned rectangles instead and num_points has to be 4
+ */
+static void make_shape_pairs(struct pair_t* pairs, int num_points, bool boxes) {
+	for (int i = 0; i < NUM_PAIRS; i++) {
+		struct pair_t* p = &pairs[i];
+		scalar_t r1 = 10 + rand() % 30, r2 = 10 + rand() % 30;
+		scalar_t x = 100 + rand() % 120 - 60, y = 100 + rand() % 120 - 60;
+
+		p->poly1 = (struct polygon_t){p->points1, num_points};
+		p->poly2 = (struct polygon_t){p->points2, num_points};
+		if (boxes) {
+			make_box(p->points1, 100 - r1, 100 - r1 / 2, 2 * r1, r1);
+			make_box(p->points2, x - r2, y - r2 / 2, 2 * r2, r2);
+		} else {
+			make_round(p->points1, num_points, 100, 100, r1);
+			make_round(p->points2, num_points, x, y, r2);
+		}
+	}
+}
+
+/*
+ * GJK, MPR and SAT for each size of polygon, which is where SHAPE_SMALL_POLYGON_POINTS comes from,
+ * then shape_collision against gjk_collision on a mix of boxes, small polygons and big ones
+ */
+static void bench_dispatch(void) {
+	srand(3);
+	struct pair_t* pairs = malloc(NUM_PAIRS * sizeof(struct pair_t));
+	struct vector_t (*normals)[2][MAX_POINTS] = malloc(NUM_PAIRS * sizeof(*normals));
+	int (*num_normals)[2] = malloc(NUM_PAIRS * sizeof(*num_normals));
+	struct shape_t (*shapes)[2] = malloc(NUM_PAIRS * sizeof(*shapes));
+	bool* answers = malloc(NUM_PAIRS * sizeof(bool));
+	char name[32];
+
+	for (int n = 3; n <= MAX_POINTS; n += n < 8 ? 1 : 4) {
+		for (int boxes = 0; boxes <= (n == 4); boxes++) {
+			make_shape_pairs(pairs, n, boxes);
+			for (int i = 0; i < NUM_PAIRS; i++) {
+				// The normals are computed once like shape_init does, which only keeps them for small polygons
+				num_normals[i][0] = sat_normals(pairs[i].poly1, normals[i][0]);
+				num_normals[i][1] = sat_normals(pairs[i].poly2, normals[i][1]);
+			}
+
+			struct result_t gjk = {0}, mpr = {0}, sat = {0};
+			long differences = 0;
+			for (int frame = 0; frame < num_frames; frame++) {
+				int64_t start = now_ns();
+				for (int i = 0; i < NUM_PAIRS; i++) {
+					answers[i] = gjk_collision(pairs[i].poly1, pairs[i].poly2, NULL);
+				}
+				gjk.ns += now_ns() - start;
+
+				start = now_ns();
+				for (int i = 0; i < NUM_PAIRS; i++) {
+					differences += mpr_collision(pairs[i].poly1, pairs[i].poly2, NULL) != answers[i];
+				}
+				mpr.ns += now_ns() - start;
+
+				start = now_ns();
+				for (int i = 0; i < NUM_PAIRS; i++) {
+					bool hit = sat_collision(pairs[i].poly1, normals[i][0], num_normals[i][0],
+							pairs[i].poly2, normals[i][1], num_normals[i][1]);
+					differences += hit != answers[i];
+					sat.hits += hit;
+				}
+				sat.ns += now_ns() - start;
+
+				gjk.queries += NUM_PAIRS;
+				mpr.queries += NUM_PAIRS;
+				sat.queries += NUM_PAIRS;
+			}
+
+			snprintf(name, sizeof(name), "%s%d", boxes ? "box " : "n=", n);
+			printf("%-10s %-7s gjk %6.1f  mpr %6.1f  sat %6.1f ns/query %6.1f%% hits  %ld answers differ\n", "dispatch", name,
+					(double)gjk.ns / gjk.queries, (double)mpr.ns / mpr.queries, (double)sat.ns / sat.queries,
+					100.0 * sat.hits / sat.queries, differences);
+		}
+	}
+
+	// A third each of boxes, small polygons and polygons with MAX_POINTS points
+	for (int i = 0; i < NUM_PAIRS; i++) {
+		struct pair_t* p = &pairs[i];
+		struct vector_t* points[2] = {p->points1, p->points2};
+		struct polygon_t* polys[2] = {&p->poly1, &p->poly2};
+		scalar_t centers[2][2] = {{100, 100}, {100 + rand() % 120 - 60, 100 + rand() % 120 - 60}};
+
+		for (int k = 0; k < 2; k++) {
+			int kind = rand() % 3;
+			scalar_t r = 10 + rand() % 30;
+			if (kind == 0) {
+				*polys[k] = (struct polygon_t){points[k], 4};
+				make_box(points[k], centers[k][0] - r, centers[k][1] - r / 2, 2 * r, r);
+			} else {
+				int num_points = kind == 1 ? 3 + rand() % (SHAPE_SMALL_POLYGON_POINTS - 2) : MAX_POINTS;
+				*polys[k] = (struct polygon_t){points[k], num_points};
+				make_round(points[k], num_points, centers[k][0], centers[k][1], r);
+			}
+		}
+		shape_init(&shapes[i][0], p->poly1);
+		shape_init(&shapes[i][1], p->poly2);
+	}
+
+	struct result_t gjk = {0}, dispatch = {0};
+	long differences = 0;
+	for (int frame = 0; frame < num_frames; frame++) {
+		int64_t start = now_ns();
+		for (int i = 0; i < NUM_PAIRS; i++) {
+			answers[i] = gjk_collision(pairs[i].poly1, pairs[i].poly2, NULL);
+			gjk.hits += answers[i];
+		}
+		gjk.ns += now_ns() - start;
+
+		start = now_ns();
+		for (int i = 0; i < NUM_PAIRS; i++) {
+			bool hit = shape_collision(&shapes[i][0], &shapes[i][1], NULL);
+			differences += hit != answers[i];
+			dispatch.hits += hit;
+		}
+		dispatch.ns += now_ns() - start;
+
+		gjk.queries += NUM_PAIRS;
+		dispatch.queries += NUM_PAIRS;
+	}
+
+	// The same pairs with penetration vectors, where boxes and small polygons skip EPA
+	struct result_t epa = {0}, dispatch_epa = {0};
+	for (int frame = 0; frame < num_frames; frame++) {
+		int64_t start = now_ns();
+		for (int i = 0; i < NUM_PAIRS; i++) {
+			struct collision_t collision;
+			if (collide(pairs[i].poly1, pairs[i].poly2, &collision)) {
+				collision_penetration(&collision);
+				epa.hits++;
+			}
+		}
+		epa.ns += now_ns() - start;
+
+		start = now_ns();
+		for (int i = 0; i < NUM_PAIRS; i++) {
+			struct vector_t penetration;
+			dispatch_epa.hits += shape_collision(&shapes[i][0], &shapes[i][1], &penetration);
+		}
+		dispatch_epa.ns += now_ns() - start;
+
+		epa.queries += NUM_PAIRS;
+		dispatch_epa.queries += NUM_PAIRS;
+	}
+
+	print_result("dispatch", "mixed, gjk_collision", gjk);
+	print_result("dispatch", "mixed, shape_collision", dispatch);
+	print_result("dispatch", "mixed, collide+epa", epa);
+	print_result("dispatch", "mixed, shape_collision+pen", dispatch_epa);
+	printf("%-10s shape_collision differs from gjk_collision in %ld queries\n", "dispatch", differences);
+
+	free(answers);
+	free(shapes);
+	free(num_normals);
+	free(normals);
+	free(pairs);
+}
+
+/*
+ * A static set much bigger than the caches, queried in random order so most support scans miss the cache.
+ * Compares polygons of struct vector_t against compact sets of int32 and int16 points
+ */
+#define NUM_COMPACT_SHAPES (1 << 19)
+#define COMPACT_POINTS 16
+
+static void bench_compact(void) {
+	srand(4);
+	struct vector_t* points = malloc((size_t)NUM_COMPACT_SHAPES * COMPACT_POINTS * sizeof(struct vector_t));
+	struct polygon_t* polys = malloc(NUM_COMPACT_SHAPES * sizeof(struct polygon_t));
+	// Kept apart from the shapes, so placing the probes doesn't bring any shape into the cache
+	struct vector_t* centers = malloc(NUM_COMPACT_SHAPES * sizeof(struct vector_t));
+	struct compact_set_t sets[2];
+	compact_init(&sets[0], COMPACT_INT32);
+	compact_init(&sets[1], COMPACT_INT16);
+
+	for (int i = 0; i < NUM_COMPACT_SHAPES; i++) {
+		polys[i] = (struct polygon_t){&points[i * COMPACT_POINTS], COMPACT_POINTS};
+		centers[i] = (struct vector_t){rand() % 60000, rand() % 60000};
+		make_round(polys[i].points, COMPACT_POINTS, centers[i].x, centers[i].y, 10 + rand() % 30);
+		compact_add(&sets[0], polys[i]);
+		compact_add(&sets[1], polys[i]);
+	}
+
+	// A box near a random shape for every query
+	int* ids = malloc(NUM_PAIRS * sizeof(int));
+	struct pair_t* probes = malloc(NUM_PAIRS * sizeof(struct pair_t));
+	bool* answers = malloc(NUM_PAIRS * sizeof(bool));
+
+	// Every set runs the same queries, and the compact sets check their answers against polys
+	for (int k = -1; k < 2; k++) {
+		srand(5);
+		struct result_t r = {0};
+		long differences = 0;
+		for (int frame = 0; frame < num_frames; frame++) {
+			for (int i = 0; i < NUM_PAIRS; i++) {
+				ids[i] = rand() % NUM_COMPACT_SHAPES;
+				probes[i].poly1 = (struct polygon_t){probes[i].points1, 4};
+				make_box(probes[i].points1, centers[ids[i]].x + rand() % 100 - 70, centers[ids[i]].y + rand() % 100 - 70, 40, 40);
+			}
+
+			if (k < 0) {
+				int64_t start = now_ns();
+				for (int i = 0; i < NUM_PAIRS; i++) {
+					r.hits += gjk_collision(polys[ids[i]], probes[i].poly1, NULL);
+				}
+				r.ns += now_ns() - start;
+			} else {
+				int64_t start = now_ns();
+				for (int i = 0; i < NUM_PAIRS; i++) {
+					answers[i] = compact_collision(&sets[k], ids[i], probes[i].poly1, NULL);
+					r.hits += answers[i];
+				}
+				r.ns += now_ns() - start;
+
+				for (int i = 0; i < NUM_PAIRS; i++) {
+					differences += answers[i] != gjk_collision(polys[ids[i]], probes[i].poly1, NULL);
+				}
+			}
+			r.queries += NUM_PAIRS;
+		}
+
+		size_t bytes = k < 0 ? NUM_COMPACT_SHAPES * (sizeof(struct polygon_t) + COMPACT_POINTS * sizeof(struct vector_t))
+				: NUM_COMPACT_SHAPES * sizeof(struct compact_entry_t) + (size_t)sets[k].num_points * 2 * sets[k].width;
+		printf("%-10s %-28s %9ld queries %8.1f ns/query %6.1f%% hits %6.1f MB  %ld answers differ\n", "compact",
+				k < 0 ? "struct vector_t points" : k == 0 ? "int32 points" : "int16 points", r.queries,
+				(double)r.ns / r.queries, 100.0 * r.hits / r.queries, bytes / 1e6, differences);
+	}
+
+	free(answers);
+	free(probes);
+	free(ids);
+	compact_free(&sets[1]);
+	compact_free(&sets[0]);
+	free(centers);
+	free(polys);
+	free(points);
+}
+
+/*
+ * One box moving through NUM_CANDIDATES shapes around it, like a player against the output of a broadphase.
+ * Compares calling gjk_collision (or collide + EPA) per candidate against query_collision in each mode
+ */
+#define NUM_CANDIDATES 500
+
+static void bench_query(void) {
+	srand(6);
+	struct vector_t* points = malloc(NUM_CANDIDATES * MAX_POINTS * sizeof(struct vector_t));
+	struct polygon_t* candidates = malloc(NUM_CANDIDATES * sizeof(struct polygon_t));
+	int* ids = malloc(NUM_CANDIDATES * sizeof(int));
+	struct query_hit_t* hits = malloc(NUM_CANDIDATES * sizeof(struct query_hit_t));
+	struct compact_set_t set;
+	compact_init(&set, COMPACT_INT16);
+
+	for (int i = 0; i < NUM_CANDIDATES; i++) {
+		int num_points = i % 2 == 0 ? 4 : MAX_POINTS;
+		scalar_t x = rand() % 1000, y = rand() % 1000, size = 20 + rand() % 30;
+		candidates[i] = (struct polygon_t){&points[i * MAX_POINTS], num_points};
+		if (num_points == 4) {
+			make_box(candidates[i].points, x, y, size, size);
+		} else {
+			make_round(candidates[i].points, num_points, x, y, size / 2);
+		}
+		compact_add(&set, candidates[i]);
+	}
+
+	struct vector_t box_points[4];
+	struct polygon_t box = {box_points, 4};
+
+	const char* names[] = {"gjk_collision per candidate", "collide + EPA per candidate", "query_collision",
+			"query_collision + EPA", "query_collision any hit", "query_collision first 4", "query_compact_collision"};
+	const int NUM_MODES = (int)(sizeof(names)/sizeof(names[0]));
+
+	for (int mode = 0; mode < NUM_MODES; mode++) {
+		struct result_t r = {0};
+		long differences = 0;
+		for (int frame = 0; frame < num_frames; frame++) {
+			make_box(box_points, 50 + frame * 900 / num_frames, 300 + frame % 7 * 50, 150, 150);
+
+			int64_t start = now_ns();
+			struct query_shape_t query;
+			int num_hits = 0;
+			switch (mode) {
+				case 0:
+					for (int i = 0; i < NUM_CANDIDATES; i++) {
+						if (gjk_collision(box, candidates[i], NULL)) {
+							hits[num_hits++] = (struct query_hit_t){i, {0, 0}};
+						}
+					}
+					break;
+				case 1:
+					for (int i = 0; i < NUM_CANDIDATES; i++) {
+						struct collision_t collision;
+						if (collide(box, candidates[i], &collision)) {
+							hits[num_hits++] = (struct query_hit_t){i, collision_penetration(&collision)};
+						}
+					}
+					break;
+				case 2:
+				case 3:
+				case 4:
+				case 5:
+					query_prepare(&query, box);
+					num_hits = query_collision(&query, candidates, NUM_CANDIDATES, mode == 4 ? 1 : mode == 5 ? 4 : QUERY_ALL_HITS,
+							mode == 3, hits);
+					break;
+				case 6:
+					for (int i = 0; i < NUM_CANDIDATES; i++) {
+						ids[i] = i;
+					}
+					query_prepare(&query, box);
+					num_hits = query_compact_collision(&query, &set, ids, NUM_CANDIDATES, QUERY_ALL_HITS, false, hits);
+					break;
+			}
+			r.ns += now_ns() - start;
+			r.queries += NUM_CANDIDATES;
+			r.hits += num_hits;
+
+			// Every hit has to collide, and without a limit every colliding candidate has to be a hit
+			int expected = 0;
+			for (int i = 0; i < NUM_CANDIDATES; i++) {
+				expected += gjk_collision(box, candidates[i], NULL);
+			}
+			for (int h = 0; h < num_hits; h++) {
+				differences += !gjk_collision(box, candidates[hits[h].index], NULL);
+			}
+			if (mode != 4 && mode != 5) {
+				differences += labs((long)expected - num_hits);
+			} else if (num_hits < (mode == 4 ? 1 : 4) && num_hits < expected) {
+				differences++;
+			}
+		}
+
+		printf("%-10s %-28s %9ld candidates %6.1f us/query %6.1f hits/query  %ld wrong\n", "query", names[mode], r.queries,
+				r.ns / 1000.0 / num_frames, (double)r.hits / num_frames, differences);
+	}
+
+	compact_free(&set);
+	free(hits);
+	free(ids);
+	free(candidates);
+	free(points);
+}
+
+/*
+ * The resting scene with lower limits: how much time they save, how many pairs they truncate and how far off the
+ * penetration depth gets. Then the whole scene as one batch with a time budget per frame
+ */
+#define BATCH_BUDGET_NS 100000
+
+static void bench_budget(void) {
+	srand(1);
+	struct pair_t* pairs = make_resting_scene();
+	struct vector_t* exact = malloc((size_t)num_frames * NUM_PAIRS * sizeof(struct vector_t));
+
+	struct query_options_t tolerance = QUERY_DEFAULT_OPTIONS;
+	tolerance.tolerance = FIXED_POINT_SCALING_FACTOR;
+	struct query_options_t capped = QUERY_DEFAULT_OPTIONS;
+	capped.max_epa_iterations = 1;
+	capped.max_gjk_iterations = 3;
+
+	const char* names[] = {"default limits", "EPA tolerance 1 px", "1 EPA, 3 GJK iterations"};
+	const struct query_options_t* options[] = {&QUERY_DEFAULT_OPTIONS, &tolerance, &capped};
+
+	for (int k = 0; k < 3; k++) {
+		struct result_t r = {0};
+		long truncated = 0;
+		double error = 0;
+		for (int frame = 0; frame < num_frames; frame++) {
+			int64_t start = now_ns();
+			for (int i = 0; i < NUM_PAIRS; i++) {
+				struct collision_t collision;
+				collide_options(pairs[i].poly1, pairs[i].poly2, options[k], &collision);
+				struct vector_t p = collision_penetration(&collision);
+				truncated += collision.status == QUERY_TRUNCATED;
+				r.hits += collision.colliding;
+
+				struct vector_t* e = &exact[frame * NUM_PAIRS + i];
+				if (k == 0) {
+					*e = p;
+				} else {
+					error += fabs(hypot(p.x, p.y) - hypot(e->x, e->y));
+				}
+			}
+			r.ns += now_ns() - start;
+			r.queries += NUM_PAIRS;
+			jitter(pairs, frame);
+		}
+
+		printf("%-10s %-28s %9ld queries %8.1f ns/query %6.2f%% truncated %8.2f px mean depth error\n", "budget", names[k],
+				r.queries, (double)r.ns / r.queries, 100.0 * truncated / r.queries, error / r.queries / (1 << 8));
+		srand(1);
+		free(pairs);
+		pairs = make_resting_scene();
+	}
+
+	// The same scene packed for the batch API
+	int32_t* coords = malloc(NUM_PAIRS * 2 * MAX_POINTS * 2 * sizeof(int32_t));
+	int32_t* offsets = malloc((2 * NUM_PAIRS + 1) * sizeof(int32_t));
+	int32_t* indices = malloc(2 * NUM_PAIRS * sizeof(int32_t));
+	uint8_t* hits = malloc(NUM_PAIRS);
+	uint8_t* statuses = malloc(NUM_PAIRS);
+	int32_t* penetrations = malloc(2 * NUM_PAIRS * sizeof(int32_t));
+
+	offsets[0] = 0;
+	for (int i = 0; i < 2 * NUM_PAIRS; i++) {
+		struct polygon_t poly = i % 2 == 0 ? pairs[i / 2].poly1 : pairs[i / 2].poly2;
+		for (int k = 0; k < poly.num_points; k++) {
+			coords[2 * (offsets[i] + k)] = poly.points[k].x;
+			coords[2 * (offsets[i] + k) + 1] = poly.points[k].y;
+		}
+		offsets[i + 1] = offsets[i] + poly.num_points;
+		indices[i] = i;
+	}
+	struct batch_polygons_t polys = {coords, offsets, 2 * NUM_PAIRS};
+
+	struct query_options_t budget = QUERY_DEFAULT_OPTIONS;
+	budget.budget_ns = BATCH_BUDGET_NS;
+	for (int k = 0; k < 2; k++) {
+		int64_t total = 0, worst = 0;
+		long skipped = 0;
+		for (int frame = 0; frame < num_frames; frame++) {
+			int64_t start = now_ns();
+			batch_collision_options(polys, indices, NUM_PAIRS, hits, penetrations, k == 0 ? NULL : &budget, statuses);
+			int64_t ns = now_ns() - start;
+			total += ns;
+			worst = ns > worst ? ns : worst;
+			for (int i = 0; i < NUM_PAIRS; i++) {
+				skipped += statuses[i] == QUERY_SKIPPED;
+			}
+		}
+
+		printf("%-10s %-28s %9d pairs   %8.1f us/frame %8.1f us worst frame %6.2f%% skipped\n", "budget",
+				k == 0 ? "batch, no budget" : "batch, 100 us budget", NUM_PAIRS, total / 1000.0 / num_frames, worst / 1000.0,
+				100.0 * skipped / ((long)num_frames * NUM_PAIRS));
+	}
+
+	free(penetrations);
+	free(statuses);
+	free(hits);
+	free(indices);
+	free(offsets);
+	free(coords);
+	free(exact);
+	free(pairs);
+}
+
+/*
+ * Time until a static set of NUM_COMPACT_SHAPES shapes answers its first NUM_PAIRS queries, when the set is built from
+ * polygons at startup and when it's mapped from a shape database. The database was just written, so its pages are
+ * still in the OS cache, like on the second run of a game
+ */
+static void bench_shapedb(void) {
+	srand(4);
+	struct vector_t* points = malloc((size_t)NUM_COMPACT_SHAPES * COMPACT_POINTS * sizeof(struct vector_t));
+	struct vector_t* centers = malloc(NUM_COMPACT_SHAPES * sizeof(struct vector_t));
+	for (int i = 0; i < NUM_COMPACT_SHAPES; i++) {
+		centers[i] = (struct vector_t){rand() % 60000, rand() % 60000};
+		make_round(&points[i * COMPACT_POINTS], COMPACT_POINTS, centers[i].x, centers[i].y, 10 + rand() % 30);
+	}
+
+	char path[] = "/tmp/gjk_bench_XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		printf("%-10s couldn't create a temporary file\n", "shapedb");
+		free(centers);
+		free(points);
+		return;
+	}
+	close(fd);
+
+	struct compact_set_t built;
+	compact_init(&built, COMPACT_INT16);
+	for (int i = 0; i < NUM_COMPACT_SHAPES; i++) {
+		compact_add(&built, (struct polygon_t){&points[i * COMPACT_POINTS], COMPACT_POINTS});
+	}
+	shapedb_write(&built, path);
+	compact_free(&built);
+
+	int* ids = malloc(NUM_PAIRS * sizeof(int));
+	struct pair_t* probes = malloc(NUM_PAIRS * sizeof(struct pair_t));
+	srand(5);
+	for (int i = 0; i < NUM_PAIRS; i++) {
+		ids[i] = rand() % NUM_COMPACT_SHAPES;
+		probes[i].poly1 = (struct polygon_t){probes[i].points1, 4};
+		make_box(probes[i].points1, centers[ids[i]].x + rand() % 100 - 70, centers[ids[i]].y + rand() % 100 - 70, 40, 40);
+	}
+
+	for (int k = 0; k < 2; k++) {
+		int64_t load_ns = 0, query_ns = 0;
+		long hits = 0;
+		for (int frame = 0; frame < num_frames; frame++) {
+			struct compact_set_t set;
+			struct shapedb_t db;
+
+			int64_t start = now_ns();
+			if (k == 0) {
+				compact_init(&set, COMPACT_INT16);
+				for (int i = 0; i < NUM_COMPACT_SHAPES; i++) {
+					compact_add(&set, (struct polygon_t){&points[i * COMPACT_POINTS], COMPACT_POINTS});
+				}
+			} else {
+				shapedb_open(&db, path);
+				set = db.set;
+			}
+			int64_t loaded = now_ns();
+			for (int i = 0; i < NUM_PAIRS; i++) {
+				hits += compact_collision(&set, ids[i], probes[i].poly1, NULL);
+			}
+			int64_t end = now_ns();
+			load_ns += loaded - start;
+			query_ns += end - loaded;
+
+			if (k == 0) {
+				compact_free(&set);
+			} else {
+				shapedb_close(&db);
+			}
+		}
+
+		printf("%-10s %-28s %9d loads %10.1f us/load %8.1f ns/query %6.1f%% hits\n", "shapedb",
+				k == 0 ? "compact_add at startup" : "shapedb_open", num_frames, load_ns / 1000.0 / num_frames,
+				(double)query_ns / ((long)num_frames * NUM_PAIRS), 100.0 * hits / ((long)num_frames * NUM_PAIRS));
+	}
+
+	unlink(path);
+	free(probes);
+	free(ids);
+	free(centers);
+	free(points);
+}
+
+/*
+ * gjk_collision against MPR's answer, and GJK + EPA against MPR's approximate penetration, on the same pairs.
+ * Accuracy is measured against EPA on the pairs both find colliding
+ */
+static void bench_mpr_pairs(const char* workload, struct pair_t* pairs, bool resting) {
+	struct result_t gjk = {0}, mpr = {0}, epa = {0}, mpr_depth = {0};
+	long differences = 0, compared = 0;
+	double depth_error = 0, angle_error = 0;
+
+	for (int frame = 0; frame < num_frames; frame++) {
+		if (resting) {
+			jitter(pairs, frame);
+		}
+
+		for (int i = 0; i < NUM_PAIRS; i++) {
+			struct polygon_t poly1 = pairs[i].poly1, poly2 = pairs[i].poly2;
+			struct collision_t collision;
+			struct mpr_result_t result;
+
+			int64_t start = now_ns();
+			bool gjk_hit = gjk_collision(poly1, poly2, NULL);
+			gjk.ns += now_ns() - start;
+
+			start = now_ns();
+			bool mpr_hit = mpr_collision(poly1, poly2, NULL);
+			mpr.ns += now_ns() - start;
+
+			start = now_ns();
+			collide(poly1, poly2, &collision);
+			struct vector_t p = collision_penetration(&collision);
+			epa.ns += now_ns() - start;
+			epa.iterations += collision.epa_iterations;
+
+			start = now_ns();
+			mpr_collision(poly1, poly2, &result);
+			mpr_depth.ns += now_ns() - start;
+			mpr_depth.iterations += result.depth_iterations;
+
+			gjk.hits += gjk_hit;
+			mpr.hits += mpr_hit;
+			epa.hits += collision.colliding;
+			mpr_depth.hits += mpr_hit;
+			differences += gjk_hit != mpr_hit;
+
+			double epa_depth = hypot(p.x, p.y), approximate_depth = hypot(result.penetration.x, result.penetration.y);
+			if (gjk_hit && mpr_hit && epa_depth > 0 && approximate_depth > 0) {
+				double c = (p.x * (double)result.penetration.x + p.y * (double)result.penetration.y) / (epa_depth * approximate_depth);
+				angle_error += acos(c < 1 ? c : 1) * 180 / M_PI;
+				depth_error += fabs(approximate_depth - epa_depth) / FIXED_POINT_SCALING_FACTOR;
+				compared++;
+			}
+		}
+		gjk.queries += NUM_PAIRS;
+		mpr.queries += NUM_PAIRS;
+		epa.queries += NUM_PAIRS;
+		mpr_depth.queries += NUM_PAIRS;
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "%s gjk", workload);
+	print_result("mpr", name, gjk);
+	snprintf(name, sizeof(name), "%s mpr", workload);
+	print_result("mpr", name, mpr);
+	snprintf(name, sizeof(name), "%s gjk + EPA", workload);
+	print_result("mpr", name, epa);
+	snprintf(name, sizeof(name), "%s mpr + depth", workload);
+	print_result("mpr", name, mpr_depth);
+	printf("%-10s %-28s %ld answers differ, against EPA: %.2f px depth, %.1f degrees normal on average\n", "mpr", workload,
+			differences, compared ? depth_error / compared : 0.0, compared ? angle_error / compared : 0.0);
+}
+
+static void bench_mpr(void) {
+	srand(7);
+	struct pair_t* pairs = make_resting_scene();
+	bench_mpr_pairs("resting", pairs, true);
+
+	make_shape_pairs(pairs, MAX_POINTS, false);
+	bench_mpr_pairs("scattered", pairs, false);
+	free(pairs);
+}
+
+/*
+ * A wide tile map with rolling ground and floating platforms. Shapes dropped onto the surface are tested against a
+ * polygon per solid tile under their bounds, and against the merged strips of tilemap_collision.
+ * Boxes sliding on flat ground shouldn't be pushed sideways, which is what the seams between tiles do
+ */
+#define TILEMAP_WIDTH 4096
+#define TILEMAP_HEIGHT 512
+#define TILE_SIZE 16
+// Tiles of flat ground under every box, which are at most 6 tiles wide
+#define FLAT_WIDTH 8
+
+static int ground_height(int x) {
+	return TILEMAP_HEIGHT / 2 + (int)lround(20 * sin(x / 40.0) + 8 * sin(x / 7.0));
+}
+
+static void bench_tilemap(void) {
+	srand(8);
+	struct tilemap_t map;
+	if (!tilemap_init(&map, TILEMAP_WIDTH, TILEMAP_HEIGHT, TILE_SIZE, (struct vector_t){0, 0})) {
+		printf("%-10s out of memory\n", "tilemap");
+		return;
+	}
+	for (int x = 0; x < TILEMAP_WIDTH; x++) {
+		for (int y = ground_height(x); y < TILEMAP_HEIGHT; y++) {
+			tilemap_set(&map, x, y, true);
+		}
+	}
+	for (int i = 0; i < TILEMAP_WIDTH / 8; i++) {
+		int x = rand() % TILEMAP_WIDTH, y = ground_height(x) - 6 - rand() % 20, w = 3 + rand() % 12;
+		for (int k = 0; k < w; k++) {
+			tilemap_set(&map, x + k, y, true);
+		}
+	}
+
+	// Every other shape is a box on its own flat stretch of ground, the others are round and sit on whatever is below them
+	for (int i = 0; i < NUM_PAIRS; i += 2) {
+		int x = i / 2 * FLAT_WIDTH, y = ground_height(x);
+		for (int k = 0; k < FLAT_WIDTH; k++) {
+			for (int row = 0; row < TILEMAP_HEIGHT; row++) {
+				tilemap_set(&map, x + k, row, row >= y);
+			}
+		}
+	}
+
+	struct pair_t* shapes = malloc(NUM_PAIRS * sizeof(struct pair_t));
+	for (int i = 0; i < NUM_PAIRS; i++) {
+		struct pair_t* p = &shapes[i];
+		scalar_t size = 12 + rand() % 40;
+		int x = i % 2 == 0 ? i / 2 * FLAT_WIDTH : rand() % TILEMAP_WIDTH;
+		int y = 0;
+		while (y < TILEMAP_HEIGHT && !tilemap_get(&map, x, y)) {
+			y++;
+		}
+
+		if (i % 2 == 0) {
+			// Stays inside the stretch while jittering
+			p->poly1 = (struct polygon_t){p->points1, 4};
+			make_box(p->points1, x * TILE_SIZE + 2 + rand() % (TILE_SIZE - 4), y * TILE_SIZE - size + 2, 2 * TILE_SIZE + size, size);
+		} else {
+			p->poly1 = (struct polygon_t){p->points1, MAX_POINTS};
+			make_round(p->points1, MAX_POINTS, x * TILE_SIZE + rand() % TILE_SIZE, y * TILE_SIZE - size / 2 + 3, size / 2);
+		}
+	}
+	int64_t start = now_ns();
+	tilemap_build(&map);
+	int64_t build_ns = now_ns() - start;
+	printf("%-10s %d x %d tiles merged into %d strips in %.1f ms\n", "tilemap", TILEMAP_WIDTH, TILEMAP_HEIGHT, map.num_strips, build_ns / 1e6);
+
+	struct tilemap_hit_t* hits = malloc(TILEMAP_WIDTH * sizeof(struct tilemap_hit_t));
+	for (int k = 0; k < 2; k++) {
+		struct result_t r = {0};
+		long contacts = 0, sideways = 0;
+		for (int frame = 0; frame < num_frames; frame++) {
+			for (int i = 0; i < NUM_PAIRS; i++) {
+				struct polygon_t poly = shapes[i].poly1;
+				translate(poly, (frame + i) % 2 ? 1 : -1, 0);
+
+				start = now_ns();
+				int num_hits = 0;
+				if (k == 0) {
+					struct aabb_t bounds = get_aabb(poly);
+					for (int y = bounds.min.y / TILE_SIZE - 1; y <= bounds.max.y / TILE_SIZE; y++) {
+						for (int x = bounds.min.x / TILE_SIZE - 1; x <= bounds.max.x / TILE_SIZE; x++) {
+							if (!tilemap_get(&map, x, y)) {
+								continue;
+							}
+							struct vector_t points[4];
+							make_box(points, x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+							struct collision_t collision;
+							if (collide(poly, (struct polygon_t){points, 4}, &collision)) {
+								hits[num_hits++].penetration = collision_penetration(&collision);
+							}
+						}
+					}
+				} else {
+					num_hits = tilemap_collision(&map, poly, QUERY_ALL_HITS, true, hits);
+				}
+				r.ns += now_ns() - start;
+				r.queries++;
+				r.hits += num_hits > 0;
+				contacts += num_hits;
+
+				// Boxes rest on flat ground with some overlap, so only an upward push is right
+				for (int h = 0; h < num_hits && i % 2 == 0; h++) {
+					sideways += hits[h].penetration.x != 0;
+				}
+			}
+		}
+		printf("%-10s %-28s %9ld queries %8.1f ns/query %6.1f%% hits %6.1f contacts/query %ld sideways pushes\n", "tilemap",
+				k == 0 ? "polygon per tile" : "tilemap_collision", r.queries, (double)r.ns / r.queries,
+				100.0 * r.hits / r.queries, (double)contacts / r.queries, sideways);
+	}
+
+	free(hits);
+	free(shapes);
+	tilemap_free(&map);
+}
+
+struct scene_t {
+	const char* name;
+	void (*run)(void);
+};
+
+static const struct scene_t SCENES[] = {
+	{"resting", bench_resting},
+	{"static", bench_static},
+	{"dispatch", bench_dispatch},
+	{"compact", bench_compact},
+	{"query", bench_query},
+	{"budget", bench_budget},
+	{"shapedb", bench_shapedb},
+	{"mpr", bench_mpr},
+	{"tilemap", bench_tilemap},
+};
+
+#define NUM_SCENES (int)(sizeof(SCENES)/sizeof(SCENES[0]))
+
+int main(int argc, char** argv) {
+	int opt;
+	while ((opt = getopt(argc, argv, "f:")) != -1) {
+		switch (opt) {
+			case 'f': num_frames = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+			default:
+				fprintf(stderr, "Usage: %s [-f frames] [scene...]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	for (int s = 0; s < NUM_SCENES; s++) {
+		bool selected = optind >= argc;
+		for (int i = optind; i < argc; i++) {
+			selected |= strcmp(argv[i], SCENES[s].name) == 0;
+		}
+
+		if (selected) {
+			SCENES[s].run();
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * Compiles src/gjk_epa/gjk.hpp and checks that gjk_epa::collision and gjk_epa::penetration give the same results
+ * as the C functions on random polygons, packed shapes and a shape type of its own. Then times both on the same pairs:
+ * the C functions only get the support functions as pointers, while the templates inline them
+ *
+ * Usage: hpp_check [pairs]
+ * Exits with 1 if any result differs
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <vector>
+
+#include "gjk_epa/gjk.hpp"
+#include "gjk_epa/collision.h"
+#include "gjk_epa/compact.h"
+
+#if __cplusplus >= 201402L
+static_assert(dot({1, 2}, {3, 4}) == 11, "vector operations are constexpr from C++14");
+#endif
+
+#define MAX_POINTS 12
+
+/*
+ * A shape type that gjk.hpp doesn't know about, found through argument dependent lookup
+ */
+struct box_t {
+	struct vector_t min;
+	struct vector_t max;
+};
+
+// The same point as get_farthest_point_in_direction on box_polygon's points, including ties
+static inline struct vector_t farthest_point(const box_t& box, struct vector_t d) {
+	if (d.x > 0 || (d.x == 0 && d.y > 0)) {
+		return {d.x > 0 ? box.max.x : box.min.x, d.y >= 0 ? box.max.y : box.min.y};
+	}
+	return {box.min.x, d.y > 0 ? box.max.y : box.min.y};
+}
+
+// Same as farthest_point, for the C functions
+static struct vector_t box_farthest_point(const void* box, struct vector_t d) {
+	return farthest_point(*static_cast<const box_t*>(box), d);
+}
+
+static struct polygon_t box_polygon(const box_t& box, struct vector_t* points) {
+	points[0] = box.min;
+	points[1] = {box.min.x, box.max.y};
+	points[2] = box.max;
+	points[3] = {box.max.x, box.min.y};
+	return {points, 4};
+}
+
+static void make_polygon(struct vector_t* points, int num_points, scalar_t x, scalar_t y, scalar_t r) {
+	double phase = (rand() % 100) / 100.0;
+	for (int i = 0; i < num_points; i++) {
+		double a = phase - 2 * M_PI * i / num_points;
+		points[i] = {x + (scalar_t)lround(r * cos(a)), y + (scalar_t)lround(r * sin(a))};
+	}
+}
+
+static bool same_vector(struct vector_t a, struct vector_t b) {
+	return a.x == b.x && a.y == b.y;
+}
+
+struct c_result_t {
+	bool colliding;
+	int gjk_iterations;
+	enum query_status_t gjk_status;
+	struct vector_t penetration;
+	int epa_iterations;
+	enum query_status_t epa_status;
+};
+
+static bool same_result(const c_result_t& a, const c_result_t& b) {
+	return a.colliding == b.colliding && a.gjk_iterations == b.gjk_iterations && a.gjk_status == b.gjk_status
+		&& same_vector(a.penetration, b.penetration) && a.epa_iterations == b.epa_iterations && a.epa_status == b.epa_status;
+}
+
+static c_result_t run_c(farthest_point_fn farthest1, const void* shape1, farthest_point_fn farthest2, const void* shape2,
+		struct vector_t d, const struct query_options_t* options, struct epa_cache_t* cache) {
+	c_result_t r = {};
+	struct simplex_t simplex;
+	r.colliding = gjk_collision_generic(farthest1, shape1, farthest2, shape2, d, options, &simplex, &r.gjk_iterations, &r.gjk_status);
+	if (r.colliding) {
+		r.penetration = epa_from_simplex_generic(farthest1, shape1, farthest2, shape2, &simplex, cache, options,
+				&r.epa_iterations, &r.epa_status);
+	}
+	return r;
+}
+
+template <class Shape1, class Shape2>
+static c_result_t run_cpp(const Shape1& shape1, const Shape2& shape2, struct vector_t d, const struct query_options_t* options,
+		struct epa_cache_t* cache) {
+	c_result_t r = {};
+	struct simplex_t simplex;
+	r.colliding = gjk_epa::collision(shape1, shape2, d, &simplex, options, &r.gjk_iterations, &r.gjk_status);
+	if (r.colliding) {
+		r.penetration = gjk_epa::penetration(shape1, shape2, &simplex, cache, options, &r.epa_iterations, &r.epa_status);
+	}
+	return r;
+}
+
+static int64_t now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+struct timed_pair_t {
+	struct polygon_t poly;
+	box_t box;
+	box_t box2;
+	struct vector_t box_d;
+	struct vector_t box2_d;
+};
+
+// Runs the queries on every pair a few times, and returns the fastest time in nanoseconds per pair
+template <class Run>
+static double time_pairs(const std::vector<timed_pair_t>& pairs, Run run) {
+	double best = 0;
+	long sum = 0;
+	for (int r = 0; r < 10; r++) {
+		int64_t start = now_ns();
+		for (const timed_pair_t& p : pairs) {
+			sum += run(p);
+		}
+		double ns = (double)(now_ns() - start) / pairs.size();
+		best = r == 0 || ns < best ? ns : best;
+	}
+	// Keeps the results alive
+	if (sum == 42) {
+		printf(" ");
+	}
+	return best;
+}
+
+static void time_c_and_cpp(const std::vector<timed_pair_t>& pairs) {
+	double c = time_pairs(pairs, [](const timed_pair_t& p) {
+		return gjk_collision_generic(polygon_farthest_point, &p.poly, box_farthest_point, &p.box, p.box_d, nullptr, nullptr, nullptr,
+				nullptr);
+	});
+	double cpp = time_pairs(pairs, [](const timed_pair_t& p) {
+		return gjk_epa::collision(p.poly, p.box, p.box_d);
+	});
+	printf("GJK, polygon and box_t:      C %6.1f ns/pair  C++ %6.1f ns/pair\n", c, cpp);
+
+	c = time_pairs(pairs, [](const timed_pair_t& p) {
+		return gjk_collision_generic(box_farthest_point, &p.box2, box_farthest_point, &p.box, p.box2_d, nullptr, nullptr, nullptr,
+				nullptr);
+	});
+	cpp = time_pairs(pairs, [](const timed_pair_t& p) {
+		return gjk_epa::collision(p.box2, p.box, p.box2_d);
+	});
+	printf("GJK, box_t and box_t:        C %6.1f ns/pair  C++ %6.1f ns/pair\n", c, cpp);
+
+	c = time_pairs(pairs, [](const timed_pair_t& p) {
+		return run_c(polygon_farthest_point, &p.poly, box_farthest_point, &p.box, p.box_d, nullptr, nullptr).penetration.x;
+	});
+	cpp = time_pairs(pairs, [](const timed_pair_t& p) {
+		return run_cpp(p.poly, p.box, p.box_d, nullptr, nullptr).penetration.x;
+	});
+	printf("GJK+EPA, polygon and box_t:  C %6.1f ns/pair  C++ %6.1f ns/pair\n", c, cpp);
+}
+
+int main(int argc, char** argv) {
+	int num_pairs = argc > 1 ? atoi(argv[1]) : 20000;
+	srand(1);
+
+	struct compact_set_t set;
+	compact_init(&set, COMPACT_INT16);
+
+	struct query_options_t limited = QUERY_DEFAULT_OPTIONS;
+	limited.max_gjk_iterations = 3;
+	limited.max_epa_iterations = 3;
+	const struct query_options_t* options[] = {nullptr, &limited};
+
+	long checks = 0, hits = 0, differences = 0;
+	std::vector<struct vector_t> points(num_pairs * MAX_POINTS);
+	std::vector<timed_pair_t> timed(num_pairs);
+	for (int i = 0; i < num_pairs; i++) {
+		struct vector_t* points1 = &points[i * MAX_POINTS];
+		struct vector_t points2[MAX_POINTS], box_points[4];
+		int n1 = 3 + rand() % (MAX_POINTS - 2), n2 = 3 + rand() % (MAX_POINTS - 2);
+		make_polygon(points1, n1, 100, 100, 10 + rand() % 60);
+		make_polygon(points2, n2, 60 + rand() % 80, 60 + rand() % 80, 10 + rand() % 60);
+		struct polygon_t poly1 = {points1, n1}, poly2 = {points2, n2};
+
+		scalar_t x = 60 + rand() % 80, y = 60 + rand() % 80;
+		box_t box = {{x, y}, {x + 5 + rand() % 60, y + 5 + rand() % 60}};
+		struct polygon_t box_poly = box_polygon(box, box_points);
+
+		struct compact_shape_t packed = compact_get(&set, compact_add(&set, poly2));
+
+		struct vector_t d = sub(get_centroid(poly2), get_centroid(poly1));
+		struct vector_t box_d = sub(get_centroid(box_poly), get_centroid(poly1));
+
+		// A second box only for the timing, from i so the checks get the same random pairs as before
+		box_t box2 = {{90 + i % 7, 90 + i % 5}, {110 + i % 20, 110 + i % 13}};
+		struct vector_t box2_d = {(box.min.x + box.max.x - box2.min.x - box2.max.x) / 2,
+			(box.min.y + box.max.y - box2.min.y - box2.max.y) / 2};
+		timed[i] = {poly1, box, box2, box_d, box2_d};
+
+		for (const struct query_options_t* o : options) {
+			// Twice with the same cache, so the second run starts from the first one's edge
+			struct epa_cache_t c_cache = {}, cpp_cache = {};
+			for (int frame = 0; frame < 2; frame++) {
+				c_result_t c = run_c(polygon_farthest_point, &poly1, polygon_farthest_point, &poly2, d, o, &c_cache);
+				c_result_t cpp = run_cpp(poly1, poly2, d, o, &cpp_cache);
+				differences += !same_result(c, cpp);
+				hits += c.colliding;
+				checks++;
+			}
+
+			c_result_t c = run_c(polygon_farthest_point, &poly1, compact_farthest_point, &packed, d, o, nullptr);
+			c_result_t cpp = run_cpp(poly1, packed, d, o, nullptr);
+			differences += !same_result(c, cpp);
+			checks++;
+
+			// The box type against the same box as a polygon
+			c = run_c(polygon_farthest_point, &poly1, polygon_farthest_point, &box_poly, box_d, o, nullptr);
+			cpp = run_cpp(poly1, box, box_d, o, nullptr);
+			differences += !same_result(c, cpp);
+			hits += c.colliding;
+			checks++;
+		}
+	}
+
+	compact_free(&set);
+	printf("%ld checks, %ld hits, %ld differences between C and C++\n", checks, hits, differences);
+	time_c_and_cpp(timed);
+	return differences == 0 ? 0 : 1;
+}
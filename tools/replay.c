@@ -0,0 +1,191 @@
+/**
+ * Replays a log written by src/gjk_epa/recorder.h, checks that every query gives the same result
+ * as when it was recorded, and times each query
+ *
+ * Usage: replay [-r repeats] [-t top] [-c] log.bin
+ *   -r  run every query this many times and keep the fastest time (default 10)
+ *   -t  list the slowest queries (default 10)
+ *   -c  print a CSV line with the timing of every query
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "gjk_epa/gjk.h"
+#include "gjk_epa/epa.h"
+#include "gjk_epa/collision.h"
+#include "gjk_epa/recorder.h"
+
+struct timing_t {
+	long index;
+	enum recorder_query_t type;
+	int num_points1;
+	int num_points2;
+	int iterations;
+	int64_t ns;
+};
+
+static const char* QUERY_NAMES[] = {
+	"gjk_collision",
+	"epa",
+	"collide",
+};
+
+static int64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Runs the query once with the options it was recorded with, and checks it against the recording.
+ * epa and gjk_collision don't take options, so they're run like they run inside: GJK from the centroids, then EPA from
+ * its simplex, which also leaves the polygons alone unlike epa
+ */
+static bool run_query(struct recorded_query_t* q) {
+	int iterations;
+
+	if (q->type == RECORD_COLLIDE) {
+		struct collision_t collision;
+		bool colliding = collide_options(q->poly1, q->poly2, &q->options, &collision);
+		struct vector_t penetration = collision_penetration(&collision);
+		iterations = collision.gjk_iterations + collision.epa_iterations;
+		return colliding == q->colliding && penetration.x == q->penetration.x && penetration.y == q->penetration.y
+			&& iterations == q->iterations;
+	}
+
+	struct simplex_t simplex;
+	struct vector_t d = sub(get_centroid(q->poly2), get_centroid(q->poly1));
+	bool colliding = gjk_collision_generic(polygon_farthest_point, &q->poly1, polygon_farthest_point, &q->poly2, d, &q->options,
+			&simplex, &iterations, NULL);
+
+	if (q->type == RECORD_GJK_COLLISION) {
+		return colliding == q->colliding && iterations == q->iterations;
+	}
+
+	struct vector_t penetration = {0, 0};
+	iterations = 0;
+	if (colliding) {
+		penetration = epa_from_simplex_options(q->poly1, q->poly2, &simplex, NULL, &q->options, &iterations, NULL);
+	}
+	return penetration.x == q->penetration.x && penetration.y == q->penetration.y && iterations == q->iterations;
+}
+
+static int compare_slowest(const void* a, const void* b) {
+	int64_t ns_a = ((const struct timing_t*)a)->ns;
+	int64_t ns_b = ((const struct timing_t*)b)->ns;
+	return (ns_a < ns_b) - (ns_a > ns_b);
+}
+
+int main(int argc, char** argv) {
+	int repeats = 10;
+	int top = 10;
+	bool csv = false;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "r:t:c")) != -1) {
+		switch (opt) {
+			case 'r': repeats = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+			case 't': top = atoi(optarg); break;
+			case 'c': csv = true; break;
+			default:
+				fprintf(stderr, "Usage: %s [-r repeats] [-t top] [-c] log.bin\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind >= argc) {
+		fprintf(stderr, "Usage: %s [-r repeats] [-t top] [-c] log.bin\n", argv[0]);
+		return 1;
+	}
+
+	FILE* f = fopen(argv[optind], "rb");
+	if (f == NULL) {
+		perror(argv[optind]);
+		return 1;
+	}
+
+	struct recorder_header_t header;
+	if (!recorder_read_header(f, &header)) {
+		fprintf(stderr, "%s: not a version %d query log\n", argv[optind], RECORDER_VERSION);
+		return 1;
+	}
+	// The other limits come with every query, but MAX_SIMPLEX_SIZE caps max_simplex_size at compile time
+	if (header.max_simplex_size != MAX_SIMPLEX_SIZE) {
+		fprintf(stderr, "WARNING: log was recorded with MAX_SIMPLEX_SIZE=%d, results may differ\n", header.max_simplex_size);
+	}
+
+	struct recorded_query_t q = {0};
+
+	struct timing_t* timings = NULL;
+	long num_queries = 0, capacity = 0, mismatches = 0;
+	int64_t total_ns[NUM_RECORD_QUERY_TYPES] = {0};
+	long counts[NUM_RECORD_QUERY_TYPES] = {0};
+
+	if (csv) {
+		printf("index,query,num_points1,num_points2,iterations,ns\n");
+	}
+
+	while (recorder_read_query(f, &q)) {
+		if (!run_query(&q)) {
+			fprintf(stderr, "MISMATCH: query %ld (%s) doesn't match the recorded result\n", num_queries, QUERY_NAMES[q.type]);
+			mismatches++;
+		}
+
+		int64_t best = INT64_MAX;
+		for (int r = 0; r < repeats; r++) {
+			int64_t start = now_ns();
+			run_query(&q);
+			int64_t ns = now_ns() - start;
+			if (ns < best) {
+				best = ns;
+			}
+		}
+
+		if (num_queries == capacity) {
+			capacity = capacity == 0 ? 1024 : 2 * capacity;
+			timings = realloc(timings, capacity * sizeof(struct timing_t));
+		}
+		timings[num_queries] = (struct timing_t) {
+			.index = num_queries,
+			.type = q.type,
+			.num_points1 = q.poly1.num_points,
+			.num_points2 = q.poly2.num_points,
+			.iterations = q.iterations,
+			.ns = best,
+		};
+		total_ns[q.type] += best;
+		counts[q.type]++;
+
+		if (csv) {
+			printf("%ld,%s,%d,%d,%d,%ld\n", num_queries, QUERY_NAMES[q.type], q.poly1.num_points, q.poly2.num_points, q.iterations, (long)best);
+		}
+		num_queries++;
+	}
+	fclose(f);
+
+	FILE* out = csv ? stderr : stdout;
+	fprintf(out, "%ld queries, %ld mismatches\n", num_queries, mismatches);
+	for (int t = 0; t < NUM_RECORD_QUERY_TYPES; t++) {
+		if (counts[t] > 0) {
+			fprintf(out, "%-14s %8ld queries %10.3f ms total %8ld ns mean\n",
+					QUERY_NAMES[t], counts[t], total_ns[t] / 1e6, (long)(total_ns[t] / counts[t]));
+		}
+	}
+
+	qsort(timings, num_queries, sizeof(struct timing_t), compare_slowest);
+	if (top > 0 && num_queries > 0) {
+		fprintf(out, "\nSlowest queries:\n");
+		for (long i = 0; i < top && i < num_queries; i++) {
+			fprintf(out, "  #%-8ld %-14s %3d x %-3d points %4d iterations %8ld ns\n", timings[i].index, QUERY_NAMES[timings[i].type],
+					timings[i].num_points1, timings[i].num_points2, timings[i].iterations, (long)timings[i].ns);
+		}
+	}
+
+	free(timings);
+	recorded_query_free(&q);
+
+	return mismatches > 0 ? 2 : 0;
+}
@@ -0,0 +1,213 @@
+/**
+ * Builds a shape database (see src/gjk_epa/shapedb.h) from polygon definitions, or checks one
+ *
+ * Usage: shapedb [-w 16|32] -o out.db polygons.txt
+ *        shapedb -c in.db
+ *   -w  bits per coordinate, relative to each shape's center (default 16)
+ *   -o  database to write
+ *   -c  verify a database and time opening it
+ *
+ * polygons.txt has one polygon per line as x and y integers separated by spaces or commas. Lines starting with # are
+ * comments. Lines can be any length. The points can be in any order, since every polygon is replaced by its convex hull.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "gjk_epa/compact.h"
+#include "gjk_epa/shapedb.h"
+
+static int64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int compare_points(const void* a, const void* b) {
+	const struct vector_t* p = a;
+	const struct vector_t* q = b;
+	if (p->x != q->x) {
+		return p->x < q->x ? -1 : 1;
+	}
+	return (p->y > q->y) - (p->y < q->y);
+}
+
+/*
+ * Andrew's monotone chain. Replaces the points with their convex hull in counterclockwise order, leaving out
+ * collinear points
+ *
+ * @param hull room for num_points + 1 points
+ * @return number of points in the hull
+ */
+static int convex_hull(struct vector_t* points, int num_points, struct vector_t* hull) {
+	qsort(points, num_points, sizeof(struct vector_t), compare_points);
+	if (num_points < 3) {
+		memcpy(hull, points, num_points * sizeof(struct vector_t));
+		return num_points;
+	}
+
+	int n = 0;
+	for (int i = 0; i < num_points; i++) {
+		while (n >= 2 && cross(sub(hull[n-1], hull[n-2]), sub(points[i], hull[n-2])) <= 0) {
+			n--;
+		}
+		hull[n++] = points[i];
+	}
+	for (int i = num_points - 2, lower = n + 1; i >= 0; i--) {
+		while (n >= lower && cross(sub(hull[n-1], hull[n-2]), sub(points[i], hull[n-2])) <= 0) {
+			n--;
+		}
+		hull[n++] = points[i];
+	}
+
+	// The last point is the first one again
+	return n - 1;
+}
+
+static int build(const char* in_path, const char* out_path, enum compact_width_t width) {
+	FILE* in = fopen(in_path, "r");
+	if (in == NULL) {
+		fprintf(stderr, "Couldn't open %s\n", in_path);
+		return 1;
+	}
+
+	struct compact_set_t set;
+	compact_init(&set, width);
+
+	// getline grows the line to fit, and the points grow with it, so a polygon can have any number of points
+	char* line = NULL;
+	size_t line_capacity = 0;
+	struct vector_t* points = NULL;
+	struct vector_t* hull = NULL;
+	size_t points_capacity = 0;
+	int line_number = 0;
+	long input_points = 0;
+	int status = 0;
+
+	ssize_t length;
+	while ((length = getline(&line, &line_capacity, in)) != -1) {
+		line_number++;
+		if (line[0] == '#') {
+			continue;
+		}
+
+		// Coordinates after the first take a digit and a separator or sign, so there are fewer points than this
+		size_t max_points = (size_t)length / 2 + 1;
+		if (max_points > points_capacity) {
+			struct vector_t* more_points = realloc(points, max_points * sizeof(struct vector_t));
+			if (more_points != NULL) {
+				points = more_points;
+			}
+			struct vector_t* more_hull = realloc(hull, (max_points + 1) * sizeof(struct vector_t));
+			if (more_hull != NULL) {
+				hull = more_hull;
+			}
+			if (more_points == NULL || more_hull == NULL) {
+				fprintf(stderr, "%s:%d: out of memory for %zu points\n", in_path, line_number, max_points);
+				status = 1;
+				break;
+			}
+			points_capacity = max_points;
+		}
+
+		int num_coords = 0;
+		char* end;
+		for (char* p = line; ; p = end) {
+			while (*p == ' ' || *p == ',' || *p == '\t') {
+				p++;
+			}
+			long v = strtol(p, &end, 10);
+			if (end == p) {
+				break;
+			}
+			if (num_coords % 2 == 0) {
+				points[num_coords / 2].x = v;
+			} else {
+				points[num_coords / 2].y = v;
+			}
+			num_coords++;
+		}
+
+		if (num_coords == 0) {
+			continue;
+		}
+		if (num_coords % 2 != 0 || num_coords < 6) {
+			fprintf(stderr, "%s:%d: a polygon needs at least 3 points of x and y\n", in_path, line_number);
+			status = 1;
+			break;
+		}
+
+		int num_points = convex_hull(points, num_coords / 2, hull);
+		input_points += num_coords / 2;
+		if (num_points < 3 || compact_add(&set, (struct polygon_t){hull, num_points}) < 0) {
+			fprintf(stderr, "%s:%d: polygon is flat or doesn't fit %d bit coordinates\n", in_path, line_number, 8 * width);
+			status = 1;
+			break;
+		}
+	}
+	fclose(in);
+
+	if (status == 0 && shapedb_write(&set, out_path)) {
+		printf("%d shapes, %ld points (%u after taking hulls), %d bit coordinates\n", set.num_shapes, input_points,
+				set.num_points, 8 * width);
+	} else {
+		status = 1;
+	}
+
+	free(hull);
+	free(points);
+	free(line);
+	compact_free(&set);
+	return status;
+}
+
+static int check(const char* path) {
+	struct shapedb_t db;
+	int64_t start = now_ns();
+	if (!shapedb_open(&db, path)) {
+		return 1;
+	}
+	int64_t open_ns = now_ns() - start;
+
+	start = now_ns();
+	bool ok = shapedb_verify(&db);
+	int64_t verify_ns = now_ns() - start;
+
+	printf("%d shapes, %u points, %d bit coordinates, %zu bytes\n", db.set.num_shapes, db.set.num_points, 8 * db.set.width, db.size);
+	printf("opened in %.1f us, verified in %.1f us (reads every page)\n", open_ns / 1000.0, verify_ns / 1000.0);
+	printf("%s\n", ok ? "ok" : "corrupt");
+
+	shapedb_close(&db);
+	return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+	const char* usage = "Usage: %s [-w 16|32] -o out.db polygons.txt\n       %s -c in.db\n";
+	const char* out_path = NULL;
+	const char* check_path = NULL;
+	enum compact_width_t width = COMPACT_INT16;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "w:o:c:")) != -1) {
+		switch (opt) {
+			case 'w': width = atoi(optarg) == 32 ? COMPACT_INT32 : COMPACT_INT16; break;
+			case 'o': out_path = optarg; break;
+			case 'c': check_path = optarg; break;
+			default:
+				fprintf(stderr, usage, argv[0], argv[0]);
+				return 1;
+		}
+	}
+
+	if (check_path != NULL) {
+		return check(check_path);
+	}
+	if (out_path == NULL || optind >= argc) {
+		fprintf(stderr, usage, argv[0], argv[0]);
+		return 1;
+	}
+	return build(argv[optind], out_path, width);
+}